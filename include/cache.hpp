@@ -0,0 +1,114 @@
+/**
+ * @file        cache.hpp
+ *
+ * @brief       Content-addressed on-disk cache of pipeline stage outputs.
+ *
+ * @details     Every stage output is identified by a StageKey, which hashes the
+ *              name of the stage, the parameters the stage depends on and the
+ *              keys of the stages it reads from. Outputs are stored as one binary
+ *              file per key, so that stages whose inputs did not change are
+ *              loaded instead of recomputed.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#pragma once
+
+#include <hmap.hpp>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <type_traits>
+
+
+/**
+ * @brief       64-bit FNV-1a hash of a stage and its inputs.
+ */
+class StageKey
+{
+private:
+    uint64_t m_Hash;
+
+public:
+    StageKey(const std::string& Stage);
+
+    StageKey& Add(const void* Data, size_t n);
+
+    template<typename T>
+    StageKey& Add(const T& Value)
+    {
+        static_assert(std::is_arithmetic<T>::value, "Only numbers can be added to a key.");
+        return Add(&Value, sizeof(T));
+    }
+
+    uint64_t Value() const;
+};
+
+
+class StageCache
+{
+private:
+    std::string m_Dir;
+
+    struct RecordHeader
+    {
+        char Magic[4];
+        uint32_t Version;
+        uint64_t Key;
+        uint32_t ElemSize;
+        uint32_t Reserved;
+        uint64_t Count;
+        float Min;
+        float Max;
+    };
+
+    std::string Filename(const std::string& Stage, uint64_t Key) const;
+    bool Open(const std::string& Stage, uint64_t Key, uint32_t ElemSize, std::ifstream& f, RecordHeader& H) const;
+    void Write(const std::string& Stage, uint64_t Key, uint32_t ElemSize, const void* Data, uint64_t Count,
+               float Min = 0.0f, float Max = 0.0f) const;
+
+public:
+    /**
+     * @brief       Open the cache stored in the directory Dir, creating it if needed.
+     */
+    StageCache(const std::string& Dir);
+
+    /**
+     * @brief       Load the output of Stage with the given key into Out.
+     *
+     * @return      false if the output is not cached, in which case Out is unchanged.
+     */
+    template<typename T>
+    bool Load(const std::string& Stage, uint64_t Key, std::vector<T>& Out) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be cached.");
+        std::ifstream f;
+        RecordHeader H;
+        if (!Open(Stage, Key, sizeof(T), f, H))
+            return false;
+        std::vector<T> Data(H.Count);
+        if (!f.read((char*)Data.data(), H.Count * sizeof(T)))
+            return false;
+        Out = std::move(Data);
+        return true;
+    }
+
+    template<typename T>
+    void Store(const std::string& Stage, uint64_t Key, const std::vector<T>& Data) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be cached.");
+        Write(Stage, Key, sizeof(T), Data.data(), Data.size());
+    }
+
+    /**
+     * @brief       Load a heightmap with the size of HM, restoring its range as well.
+     *
+     * @return      false if the heightmap is not cached, in which case HM is unchanged.
+     */
+    bool Load(const std::string& Stage, uint64_t Key, HeightMap& HM) const;
+    void Store(const std::string& Stage, uint64_t Key, const HeightMap& HM) const;
+};
\ No newline at end of file
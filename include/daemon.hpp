@@ -0,0 +1,46 @@
+/**
+ * @file        daemon.hpp
+ *
+ * @brief       Long-running generation service over a Unix domain socket.
+ *
+ * @details     Clients connect to the socket and send one request per line, as a
+ *              JSON object. Every request gets a reply line, also a JSON object,
+ *              with a "status" of either "ok" or "error" (and a "message").
+ *              Requests:
+ *              - {"command": "generate", "params": {...}, "reply": "bytes"}
+ *                generates the configuration in "params" (same format as the
+ *                configuration files, "output_file" is optional) and replies with
+ *                {"status": "ok", "width": w, "height": h, "bytes": n}, followed
+ *                by n bytes holding the heightmap as row-major native floats.
+ *              - {"command": "generate", "params": {...}, "reply": "file"}
+ *                exports the heightmap to params.output_file and replies with
+ *                {"status": "ok", "path": ...}.
+ *              - {"command": "stats"} replies with the number of requests and the
+ *                latency percentiles of the generations.
+ *              - {"command": "shutdown"} stops the daemon.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#pragma once
+
+#include <string>
+
+
+/**
+ * @brief       Serve requests on the socket at SocketPath until a shutdown request,
+ *              SIGINT or SIGTERM.
+ *
+ * @details     The calling thread accepts connections and reads their requests, which
+ *              are answered by Workers threads, each of which owns a RiverGenerator
+ *              and an output buffer that stay warm across requests. Workers are only
+ *              busy with complete requests, so idle connections never hold one.
+ *              A value of 0 uses one worker per hardware thread.
+ *
+ * @throws std::runtime_error if the socket cannot be created, or on platforms
+ *         without Unix domain sockets.
+ */
+void run_daemon(const std::string& SocketPath, int Workers = 0);
\ No newline at end of file
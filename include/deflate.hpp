@@ -0,0 +1,56 @@
+/**
+ * @file        deflate.hpp
+ *
+ * @brief       Minimal zlib/deflate encoder and checksums.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+
+uint32_t crc32(uint32_t crc, const unsigned char* data, size_t n);
+
+uint32_t adler32(uint32_t adler, const unsigned char* data, size_t n);
+
+/**
+ * @brief       Checksum of the concatenation of two buffers.
+ *
+ * @param adler1    Adler-32 of the first buffer.
+ * @param adler2    Adler-32 of the second buffer.
+ * @param len2      Length of the second buffer.
+ */
+uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2);
+
+
+/**
+ * @brief       Compress a chunk of data into non-final deflate blocks.
+ *
+ * @details     The chunk is compressed independently from any other data, using
+ *              LZ77 over the chunk itself and the fixed Huffman codes, and it is
+ *              terminated by an empty stored block, so that it ends on a byte
+ *              boundary. This means that compressed chunks can be produced in
+ *              any order (or concurrently) and simply concatenated between
+ *              zlib_header() and zlib_trailer().
+ *
+ * @param data      Input bytes.
+ * @param n         Number of input bytes.
+ * @param level     Compression level in [0, 9]. Level 0 emits stored blocks.
+ * @param out       Compressed bytes are appended here.
+ */
+void deflate_chunk(const unsigned char* data, size_t n, int level, std::vector<unsigned char>& out);
+
+void zlib_header(int level, std::vector<unsigned char>& out);
+
+/**
+ * @brief       Terminate a zlib stream with an empty final block and the
+ *              Adler-32 of the uncompressed data.
+ */
+void zlib_trailer(uint32_t adler, std::vector<unsigned char>& out);
\ No newline at end of file
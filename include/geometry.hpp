@@ -13,11 +13,186 @@
 
 #include <SFML/Graphics.hpp>
 #include <hmap.hpp>
+#include <sampling.hpp>
+#include <spline.hpp>
+#include <tasks.hpp>
 #include <vector>
 #include <set>
+#include <string>
 
 
 HeightMap river(int w, int h, int nodes, int samples, float thickness, int ksx, int ksy, float sigma, int seed = 0);
+
+/**
+ * @brief       Draw and blur the river's bed into HM.
+ *
+ * @details     Canvas and Scratch let the caller reuse the render target and the
+ *              blur buffer across calls. When null, they are allocated here.
+ *              A canvas whose size differs from the map is re-created.
+ */
+void river(HeightMap& HM, int nodes, int samples, float thickness, int ksx, int ksy, float sigma, int seed = 0,
+           sf::RenderTexture* Canvas = nullptr, float* Scratch = nullptr);
+
+/**
+ * @brief       Stages of river(), which can be run separately to reuse their results.
+ *
+ * @details     river_points() samples nodes points of the unit square plus the
+ *              river's source and target, which are the last two points. Poisson
+ *              sampling fills the square with points no closer than MinDistance,
+ *              which is derived from nodes if 0. With the Philox generator, node
+ *              k only depends on the seed and on k, and nodes are sampled in
+ *              parallel on Pool.\n
+ *              river_path() returns the indices of the points on the shortest path
+ *              from the source to the target along the edges E, which weigh Costs
+ *              if given, and their length otherwise. It throws std::runtime_error if
+ *              the target cannot be reached.\n
+ *              river_polyline() samples the spline of the given type through the
+ *              path at nodes parameters, in unit square coordinates. Catmull-Rom
+ *              curves are sampled a segment at a time with Spline::Segment().\n
+ *              river_bed() draws the polyline with the given thickness into HM
+ *              and blurs it. The polyline is drawn as a single stroke of quads
+ *              with round joins, in one draw call. With NarrowBand, only the
+ *              spans of each row that the blurred stroke can reach are blurred,
+ *              only their bounding box is read back from the render target, and
+ *              the rest of HM is set to zero, which gives the same map at a cost
+ *              proportional to the area of the river.
+ */
+std::vector<sf::Vector2f> river_points(int nodes, int seed, NodeSampler Sampler = NodeSampler::Uniform,
+                                       float MinDistance = 0.0f, NodeRng Rng = NodeRng::MT19937,
+                                       ThreadPool* Pool = nullptr);
+std::vector<int> river_path(const std::vector<sf::Vector2f>& P, const std::vector<std::pair<int, int>>& E,
+                            const std::vector<float>& Costs = { });
+std::vector<sf::Vector2f> river_polyline(const std::vector<sf::Vector2f>& P, const std::vector<int>& Path, int nodes,
+                                         SplineType Type = SplineType::Natural);
+void river_bed(HeightMap& HM, const std::vector<sf::Vector2f>& Polyline, float thickness, int ksx, int ksy, float sigma,
+               sf::RenderTexture* Canvas = nullptr, float* Scratch = nullptr, bool NarrowBand = true);
+
+/**
+ * @brief       Stages of a river with tributaries, built from a single search.
+ *
+ * @details     river_network() runs one Dijkstra from the target over the edges E,
+ *              weighted and checked as in river_path(), and returns the branches of
+ *              the network as indices of points. The first branch is the main stem,
+ *              from the source to the target. It is followed by the paths down the
+ *              tree of up to Tributaries random nodes, each one ending at the node
+ *              where it joins a previous branch, so every branch costs time linear in
+ *              its length.\n
+ *              river_network_polylines() samples the spline through each branch,
+ *              in the same way, including its ends, with a number of samples proportional to its
+ *              number of nodes (nodes for the main stem). It also returns the width
+ *              at each sample relative to the outlet, which grows with the square
+ *              root of the length of the channels upstream.\n
+ *              This river_bed() draws every polyline with the given thickness in
+ *              pixels at each point, all of them in one draw call. The thickness
+ *              varies linearly along each segment.
+ */
+std::vector<std::vector<int>> river_network(const std::vector<sf::Vector2f>& P, const std::vector<std::pair<int, int>>& E,
+                                            int Tributaries, int seed, const std::vector<float>& Costs = { });
+void river_network_polylines(const std::vector<sf::Vector2f>& P, const std::vector<std::vector<int>>& Branches, int nodes,
+                             std::vector<std::vector<sf::Vector2f>>& Polylines, std::vector<std::vector<float>>& Widths,
+                             SplineType Type = SplineType::Natural);
+void river_bed(HeightMap& HM, const std::vector<std::vector<sf::Vector2f>>& Polylines,
+               const std::vector<std::vector<float>>& Thickness, int ksx, int ksy, float sigma,
+               sf::RenderTexture* Canvas = nullptr, float* Scratch = nullptr, bool NarrowBand = true);
+
+
+/**
+ * @brief       Cost of following each edge of E over the terrain Relief, whose
+ *              heights are in [0, 1] and cover the unit square.
+ *
+ * @details     Heights are interpolated bilinearly at Samples evenly spaced points
+ *              of each edge, ends included, and the edge costs
+ *                  length * (1 + HeightWeight * mean height) + SlopeWeight * climb,
+ *              where the climb sums the height differences between consecutive
+ *              samples, so that the cheapest paths run along valleys.\n
+ *              Edges are interpolated four at a time with SSE2 where available,
+ *              and split over the threads of Pool, if given.
+ *
+ * @throws std::runtime_error if Samples is less than 2.
+ */
+std::vector<float> terrain_edge_costs(const HeightMap& Relief, const std::vector<sf::Vector2f>& P,
+                                      const std::vector<std::pair<int, int>>& E, float HeightWeight, float SlopeWeight,
+                                      int Samples = 8, ThreadPool* Pool = nullptr);
+
 std::set<std::pair<int, int>> delaunay(const std::vector<sf::Vector2f>& P);
+
+/**
+ * @brief       Same edges as delaunay(P), computed in blocks on the threads of Pool,
+ *              if given.
+ *
+ * @details     Every block is triangulated with an incremental algorithm that
+ *              locates points by walking, so this is also much faster than
+ *              delaunay() on a single thread.\n
+ *              Predicates are evaluated in double precision, so the two can
+ *              disagree on nearly cocircular points, where delaunay() rounds.
+ */
+std::set<std::pair<int, int>> delaunay_parallel(const std::vector<sf::Vector2f>& P, ThreadPool* Pool = nullptr);
+
+/**
+ * @brief       Graph the river is routed on.
+ */
+enum class ProximityGraph
+{
+    Delaunay,           // The Delaunay triangulation
+    Gabriel,            // Delaunay edges whose diametral circle is empty
+    RNG,                // Delaunay edges whose lune is empty (relative neighbourhood graph)
+    KNN                 // Every point joined to its k nearest neighbours
+};
+
+ProximityGraph parse_proximity_graph(const std::string& name);
+
+/**
+ * @brief       Sparse subgraphs of the Delaunay edges E of P.
+ *
+ * @details     gabriel_graph() keeps the edges ab such that no point lies strictly
+ *              inside the circle of diameter ab, and relative_neighbourhood_graph()
+ *              those such that no point is closer to both a and b than they are to
+ *              each other. Each is a subgraph of the previous one and contains the
+ *              minimum spanning tree, so they are connected whenever E is. Points
+ *              are only searched along the Delaunay edges around a and b, which
+ *              takes expected linear time for uniform points.
+ */
+std::vector<std::pair<int, int>> gabriel_graph(const std::vector<sf::Vector2f>& P, const std::vector<std::pair<int, int>>& E);
+std::vector<std::pair<int, int>> relative_neighbourhood_graph(const std::vector<sf::Vector2f>& P,
+                                                              const std::vector<std::pair<int, int>>& E);
+
+/**
+ * @brief       Edges from every point of P to its k nearest neighbours, without
+ *              repetitions, searched on the threads of Pool, if given.
+ *
+ * @details     Points are bucketed in a uniform grid over their bounding box, with
+ *              about two points per cell, and each search visits rings of cells of
+ *              growing size until no closer point can be found, which takes expected
+ *              constant time on uniform points. The graph needs not be connected.
+ *
+ * @throws std::runtime_error if k is less than 1.
+ */
+std::vector<std::pair<int, int>> knn_graph(const std::vector<sf::Vector2f>& P, int k, ThreadPool* Pool = nullptr);
 void gauss_blur(sf::Image& Img, int ksx, int ksy, float sigma);
-void gauss_blur(HeightMap& HM, int ksx, int ksy, float sigma);
\ No newline at end of file
+
+/**
+ * @brief       Intervals of columns [first, second) of each row of a map, sorted
+ *              and disjoint. The spans of row j are Spans[Rows[j]], ...,
+ *              Spans[Rows[j + 1] - 1].
+ */
+struct RowSpans
+{
+    std::vector<int> Rows;
+    std::vector<std::pair<int, int>> Spans;
+};
+
+/**
+ * @brief       Separable gaussian blur of a heightmap.
+ *
+ * @details     If Scratch is not null, it is used as support memory, and it must
+ *              hold at least gauss_blur_scratch_size() floats.\n
+ *              The second gauss_blur() only processes the pixels of Band, and
+ *              assumes that HM is zero outside of Band shrunk by ksx columns and
+ *              ksy rows, so that the blurred map is zero outside of Band. The
+ *              result is then the same as the one of the full blur, at a cost
+ *              proportional to the area of the band. The range of HM is extended
+ *              as if every pixel had been set.
+ */
+void gauss_blur(HeightMap& HM, int ksx, int ksy, float sigma, float* Scratch = nullptr);
+void gauss_blur(HeightMap& HM, const RowSpans& Band, int ksx, int ksy, float sigma, float* Scratch = nullptr);
+size_t gauss_blur_scratch_size(int w, int h, int ksx, int ksy);
\ No newline at end of file
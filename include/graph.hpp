@@ -35,23 +35,76 @@ struct Path
 };
 
 
+/**
+ * @brief       Shortest paths from every vertex of a graph to a common root.
+ */
+struct PathTree
+{
+    int Root;
+    std::vector<int> Next;          // Next vertex towards the root, -1 for the root and unreachable vertices
+    std::vector<float> Dist;        // Length of the shortest path to the root
+
+    /**
+     * @brief       The path from v to the root, in time linear in its length.
+     */
+    Path PathToRoot(int v) const;
+};
+
+
+
+/**
+ * @brief       Order of the vertices of a graph in memory.
+ */
+enum class VertexOrder
+{
+    Input,              // The order of the embedding
+    Morton,             // Along the Z-order curve of the embedding
+    Hilbert             // Along the Hilbert curve of the embedding
+};
+
 
 /**
  * @brief       A graph-like data structure.
  * 
  * @details     This class represents a graph embedded in 3D space.\n 
  *              The embedding of the graph determines the weights of the edges, since
- *              the weight of each edge is defined as its Euclidean length.
+ *              the weight of each edge is defined as its Euclidean length, unless explicit
+ *              weights are given.\n
+ *              Adjacency lists are stored in compressed rows, with destinations and
+ *              weights in separate arrays. Vertices can be renumbered along a space
+ *              filling curve, so that vertices close in the plane are also close in
+ *              memory and searches over large graphs touch fewer cache lines. The
+ *              renumbering is internal: every method takes and returns the indices
+ *              of the vertices in V.
  */
 class Graph
 {
 private:
     std::vector<int> m_Idxs;
-    std::vector<WEdge> m_Adjs;
+    std::vector<int> m_Dests;
+    std::vector<float> m_Weights;
+    std::vector<int> m_Order;           // Index in V of each vertex, empty if not renumbered
+    std::vector<int> m_Rank;            // Vertex of each index in V
+
+    void Build(const std::vector<sf::Vector2f>& V, const std::vector<std::pair<int, int>>& E,
+               const float* Weights, VertexOrder Order);
+    void Dijkstra(int s, int t, std::vector<float>& Dist, std::vector<int>& Pred) const;
+    int Vertex(int i) const { return m_Rank.empty() ? i : m_Rank[i]; }
+    int Original(int v) const { return m_Order.empty() ? v : m_Order[v]; }
 
 public:
-    Graph(const std::vector<sf::Vector2f>& V, const std::vector<std::pair<int, int>>& E);
-    Graph(const std::vector<sf::Vector2f>& V, const std::set<std::pair<int, int>>& E);
+    Graph(const std::vector<sf::Vector2f>& V, const std::vector<std::pair<int, int>>& E,
+          VertexOrder Order = VertexOrder::Input);
+    Graph(const std::vector<sf::Vector2f>& V, const std::set<std::pair<int, int>>& E,
+          VertexOrder Order = VertexOrder::Input);
+
+    /**
+     * @brief       A graph whose edges weigh Weights instead of their length.
+     *
+     * @throws std::runtime_error if E and Weights have different sizes.
+     */
+    Graph(const std::vector<sf::Vector2f>& V, const std::vector<std::pair<int, int>>& E,
+          const std::vector<float>& Weights, VertexOrder Order = VertexOrder::Input);
     Graph(const Graph& G);
     Graph& operator=(const Graph& G);
     Graph(Graph&& G);
@@ -62,7 +115,18 @@ public:
     int NumAdjacents(int i) const;
     int NumEdges() const;
 
-    const WEdge& GetAdjacent(int node_i, int adj_i) const;
+    WEdge GetAdjacent(int node_i, int adj_i) const;
+
+    /**
+     * @brief       The index in V of the vertices, in the order they are stored.
+     *              Empty if the vertices were not renumbered.
+     */
+    const std::vector<int>& GetOrder() const;
 
     Path ShortestPath(int src, int trg) const;
+
+    /**
+     * @brief       All the shortest paths to root, from a single search.
+     */
+    PathTree ShortestPathTree(int root) const;
 };
\ No newline at end of file
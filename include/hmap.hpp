@@ -12,6 +12,7 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <string>
 
 
 class HeightMap
@@ -23,7 +24,17 @@ private:
     float m_Min;                // Min value on the terrain
     float m_Max;                // Max value on the terrain
     bool m_QDirty;              // Quantized data is not updated
-    unsigned char* m_QData;     // Quantized height data (for exporting)
+    unsigned char* m_QData;     // Quantized height data (for exporting), allocated on demand
+
+    void* m_MapBase;            // Base address of the file mapping, if mapped
+    size_t m_MapSize;           // Size in bytes of the file mapping
+    bool m_MapShared;           // Writes go back to the mapped file
+    void* m_MapHandle;          // File mapping handle (Windows only)
+    bool m_Borrowed;            // m_Data is owned by the caller
+
+    HeightMap();
+    void Release();
+    void MapFile(const std::string& Filename, size_t Size, bool Create, bool Shared);
 
 public:
     /**
@@ -41,6 +52,19 @@ public:
      */
     HeightMap(int Width, int Height);
 
+    /**
+     * @brief       Wrap a caller-owned Width-by-Height row-major buffer.
+     *
+     * @details     The heightmap reads and writes Data directly and never frees
+     *              it, so Data must outlive the heightmap. Its content is left
+     *              untouched, and the value range starts as [0, 0].
+     *
+     * @param Width
+     * @param Height
+     * @param Data
+     */
+    HeightMap(int Width, int Height, float* Data);
+
     /**
      * @brief       Initialize from SFML Image.
      * 
@@ -48,6 +72,31 @@ public:
      */
     HeightMap(const sf::Image& Img);
 
+    /**
+     * @brief       Create a Width-by-Height heightmap backed by a memory-mapped file.
+     *
+     * @details     The file holds a small header followed by the raw float grid,
+     *              and every write to the map goes straight to the file pages,
+     *              so the map can be larger than the available memory.\n
+     *              An existing file is overwritten.
+     *
+     * @param Filename
+     * @param Width
+     * @param Height
+     */
+    static HeightMap CreateMapped(const std::string& Filename, int Width, int Height);
+
+    /**
+     * @brief       Open a heightmap saved with CreateMapped(), without copying it.
+     *
+     * @details     If Writable is false, the file is mapped copy-on-write: reads
+     *              share the file pages, and writes stay private to this object.
+     *
+     * @param Filename
+     * @param Writable
+     */
+    static HeightMap OpenMapped(const std::string& Filename, bool Writable = false);
+
     HeightMap(const HeightMap& HM);
     HeightMap(HeightMap&& HM);
     HeightMap& operator=(const HeightMap& HM);
@@ -68,6 +117,12 @@ public:
 
     void Set(int i, int j, float value);
 
+    /**
+     * @brief       Set the range reported by GetMin() and GetMax(), for callers
+     *              that write the heights through RawData().
+     */
+    void SetRange(float Min, float Max);
+
     void Clamp(float min = 0.0f, float max = 1.0f);
     HeightMap Clamped(float min = 0.0f, float max = 1.0f) const;
 
@@ -78,8 +133,18 @@ public:
     HeightMap Inverted() const;
 
 
+    bool IsMapped() const;
+
+    /**
+     * @brief       Store the value range in the file header and write dirty
+     *              pages back to disk. Does nothing for heap-backed maps.
+     */
+    void Flush();
+
+
     void Quantize();
     bool IsDirty() const;
     const unsigned char* const Quantized() const;
     const float* const RawData() const;
+    float* RawData();
 };
\ No newline at end of file
@@ -0,0 +1,92 @@
+/**
+ * @file        hmap_io.hpp
+ *
+ * @brief       High precision heightmap exporters.
+ *
+ * @details     These exporters read the floating point data of the heightmap
+ *              directly and encode it band by band, so they do not rely on
+ *              the 8-bit quantized copy.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#pragma once
+
+#include <hmap.hpp>
+#include <string>
+
+
+/**
+ * @brief       PNG row filter.
+ *
+ * @details     Adaptive picks, for every row, the filter with the smallest sum
+ *              of absolute residuals, which is the heuristic used by libpng.
+ *              Smooth heightmaps usually end up with Up or Paeth.
+ */
+enum class PngFilter
+{
+    None = 0,
+    Sub = 1,
+    Up = 2,
+    Average = 3,
+    Paeth = 4,
+    Adaptive
+};
+
+PngFilter parse_png_filter(const std::string& name);
+
+struct PngOptions
+{
+    int Level = 6;                          // Deflate level in [0, 9]
+    PngFilter Filter = PngFilter::Adaptive;
+    int Threads = 0;                        // 0 means one per hardware thread
+};
+
+
+/**
+ * @brief       Export as a grayscale PNG with 8 or 16 bits per sample.
+ *
+ * @details     Heights are mapped linearly from [GetMin(), GetMax()] to the
+ *              full range of the sample type.\n
+ *              Row bands are filtered and compressed concurrently as independent
+ *              deflate chunks, which are joined in order into a single zlib
+ *              stream.
+ */
+void export_hmap_png(const std::string& filename, const HeightMap& HM, int BitDepth = 16,
+                     const PngOptions& Opts = PngOptions());
+
+/**
+ * @brief       Export as headerless little-endian unsigned 16-bit samples.
+ */
+void export_hmap_r16(const std::string& filename, const HeightMap& HM);
+
+/**
+ * @brief       Export as headerless little-endian 32-bit floats.
+ *
+ * @details     Heights are written unchanged, without any normalization.
+ */
+void export_hmap_r32(const std::string& filename, const HeightMap& HM);
+
+/**
+ * @brief       Export as an uncompressed single channel 32-bit float TIFF.
+ *
+ * @details     Heights are written unchanged, without any normalization.
+ */
+void export_hmap_tiff(const std::string& filename, const HeightMap& HM);
+
+/**
+ * @brief       Export with the format given by the extension of filename.
+ *
+ * @details     Supported extensions are .png, .r16, .raw, .r32, .tif, .tiff,
+ *              .hdr, .jpg, .jpeg and .bmp. Maps created with
+ *              HeightMap::CreateMapped() are flushed instead when the extension
+ *              is .rthm. Unknown extensions fall back to PNG.\n
+ *              BitDepth and Opts only apply to PNG files.
+ *
+ * @return      The path of the written file.
+ */
+std::string export_hmap(const std::string& filename, HeightMap& HM, int BitDepth = 8,
+                        const PngOptions& Opts = PngOptions());
\ No newline at end of file
@@ -0,0 +1,68 @@
+/**
+ * @file        layers.hpp
+ *
+ * @brief       Unweighted terrain layers, for fast recomposition.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#pragma once
+
+#include <hmap.hpp>
+
+
+/**
+ * @brief       The layers a terrain is made of, kept in memory without weights.
+ *
+ * @details     The final map is the sum of the river's bed and of the weighted
+ *              Voronoi and Perlin layers, inverted and raised by the delta ramp.
+ *              Once the layers are generated (see RiverGenerator::GenerateLayers()),
+ *              Compose() rebuilds the map for any weights and delta in two
+ *              vectorized passes, without running any other stage.\n
+ *              With a noise graph (RiverParams::Noise), the Perlin layer holds its
+ *              output and the Voronoi layer is empty, so Generate() corresponds
+ *              to the weights 0 and 1.
+ */
+class LayerStack
+{
+private:
+    HeightMap m_Bed;
+    HeightMap m_Voronoi;
+    HeightMap m_Perlin;
+
+public:
+    LayerStack(int Width, int Height);
+
+    int GetWidth() const;
+    int GetHeight() const;
+
+    HeightMap& Bed();
+    HeightMap& Voronoi();
+    HeightMap& Perlin();
+    const HeightMap& Bed() const;
+    const HeightMap& Voronoi() const;
+    const HeightMap& Perlin() const;
+
+    /**
+     * @brief       Compose the layers into Out, which must have the size of the stack.
+     *
+     * @details     The result, including its range, is exactly the one produced by
+     *              RiverGenerator::Generate() with the same weights and delta.
+     *
+     * @throws std::runtime_error if the size of Out does not match.
+     */
+    void Compose(float VoronoiWeight, float PerlinWeight, float PlaneDelta, HeightMap& Out) const;
+};
+
+
+/**
+ * @brief       Compose the layers Bed, Voronoi and Perlin into Out, as in
+ *              LayerStack::Compose(). Out can be Bed itself.
+ *
+ * @throws std::runtime_error if the sizes of the maps do not match.
+ */
+void compose_layers(const HeightMap& Bed, const HeightMap& Voronoi, const HeightMap& Perlin,
+                    float VoronoiWeight, float PerlinWeight, float PlaneDelta, HeightMap& Out);
\ No newline at end of file
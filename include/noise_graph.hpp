@@ -0,0 +1,109 @@
+/**
+ * @file        noise_graph.hpp
+ *
+ * @brief       Noise layers described as graphs of noise nodes.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#pragma once
+
+#include <hmap.hpp>
+#include <string>
+#include <vector>
+
+
+enum class NoiseOp
+{
+    Const,
+    FBM,
+    Ridged,
+    Cellular,
+    Spectral,
+    Warp,
+    Add,
+    Mul,
+    Clamp
+};
+
+NoiseOp parse_noise_op(const std::string& name);
+
+
+/**
+ * @brief       A node of a NoiseGraph. Only the fields of its operation are used.
+ *
+ * @details     Generators (FBM, Ridged, Cellular, Spectral) are evaluated at the
+ *              map coordinates (u, v), which go from 0 to 1 across the map, times
+ *              Scale. Warp evaluates A at (u, v) displaced by Amount times a pair
+ *              of FBM fields of Scale, Octaves and Seed. Add and Mul combine A and
+ *              B, and Clamp restricts A to [Min, Max].
+ */
+struct NoiseNode
+{
+    NoiseOp Op = NoiseOp::Const;
+    int A = -1;                 // Input nodes, which come earlier in the graph
+    int B = -1;
+    int Seed = 0;
+    int Octaves = 1;
+    float Value = 0.0f;         // Const
+    float Scale = 1.0f;
+    float Lacunarity = 2.0f;    // FBM, Ridged
+    float Gain = 0.5f;
+    float Offset = 1.0f;        // Ridged
+    float Beta = 2.0f;          // Spectral
+    float Amount = 0.0f;        // Warp
+    float Min = 0.0f;           // Clamp
+    float Max = 1.0f;
+};
+
+
+/**
+ * @brief       A noise layer built from generator, warp and arithmetic nodes.
+ *
+ * @details     Nodes are added in topological order, so that graphs cannot have
+ *              cycles, and any node can feed several others.\n
+ *              Evaluate() compiles the nodes reachable from the output into a
+ *              list of instructions, each running a kernel specialized for its
+ *              operation and operands over a block of samples. Constants are
+ *              folded, multiplications by a constant are fused with the addition
+ *              that consumes them, and nodes shared under the same coordinates
+ *              are evaluated once. There is no dispatch per sample, so the graph
+ *              runs as fast as the equivalent hand-written loops.\n
+ *              With seed 0 and the default lacunarity and gain, FBM and Cellular
+ *              are the noises of add_perlin() and add_voronoi().
+ */
+class NoiseGraph
+{
+private:
+    std::vector<NoiseNode> m_Nodes;
+    int m_Output;
+
+public:
+    NoiseGraph();
+
+    /**
+     * @brief       Append Node to the graph, and return its index.
+     *
+     * @throws std::runtime_error if an input of Node is not already in the graph.
+     */
+    int Add(const NoiseNode& Node);
+
+    /**
+     * @throws std::runtime_error if Node is not in the graph.
+     */
+    void SetOutput(int Node);
+
+    bool IsEmpty() const;
+    int GetOutput() const;
+    const std::vector<NoiseNode>& GetNodes() const;
+
+    /**
+     * @brief       Add alpha times the output of the graph to HM.
+     *
+     * @throws std::runtime_error if the graph has no output.
+     */
+    void Evaluate(HeightMap& HM, float alpha = 1.0f) const;
+};
\ No newline at end of file
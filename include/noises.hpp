@@ -14,7 +14,38 @@
 #include <hmap.hpp>
 
 
-void add_perlin(HeightMap& HM, float alpha, float scale, int octaves);
-HeightMap perlin(int width, int height, float scale, int octaves);
+/**
+ * @brief       Add alpha times fractal Perlin noise to HM.
+ *
+ * @details     With Multires, each octave is evaluated on a grid matched to its
+ *              frequency, and the grids are upsampled bicubically and summed.
+ *              Only the octaves that need about as many samples as the map are
+ *              evaluated at every pixel. The result differs from the full
+ *              evaluation by the interpolation error of the coarse octaves.
+ */
+void add_perlin(HeightMap& HM, float alpha, float scale, int octaves, bool Multires = false);
+HeightMap perlin(int width, int height, float scale, int octaves, bool Multires = false);
 void add_voronoi(HeightMap& HM, float alpha, float scale);
-HeightMap voronoi(int width, int height, float scale);
\ No newline at end of file
+HeightMap voronoi(int width, int height, float scale);
+
+/**
+ * @brief       Distance from (u, v) to the nearest feature point of the Voronoi
+ *              noise, which has one point per unit cell. Seed 0 gives the points
+ *              of add_voronoi().
+ */
+float voronoi_distance(float u, float v, unsigned int seed = 0);
+
+/**
+ * @brief       Add alpha times fractal noise synthesized in the frequency domain
+ *              to HM.
+ *
+ * @details     White noise drawn from seed is filtered with the FFT so that its
+ *              power spectrum falls as 1 / f^beta, which gives fractional Brownian
+ *              surfaces for beta between 2 and 4 (beta = 2 H + 2 for a Hurst
+ *              exponent H). The cost is O(N log N) for N pixels, independent of
+ *              the range of frequencies, and power-of-two sizes are the fastest.\n
+ *              The noise is periodic with the size of the map, so the map tiles
+ *              seamlessly with copies of itself. It is scaled to [-1, 1].
+ */
+void add_spectral(HeightMap& HM, float alpha, float beta, int seed);
+HeightMap spectral(int width, int height, float beta, int seed);
\ No newline at end of file
@@ -12,6 +12,11 @@
 #pragma once
 
 #include <nlohmann/json.hpp>
+#include <resample.hpp>
+#include <sampling.hpp>
+#include <geometry.hpp>
+#include <hmap_io.hpp>
+#include <noise_graph.hpp>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -24,22 +29,53 @@ struct RiverParams
     float PerlinWeight;
     float PerlinScale;
     int PerlinOctaves;
+    bool PerlinMultires;
     float VoronoiWeight;
     float VoronoiScale;
+    NoiseGraph Noise;                   // Replaces the Voronoi and Perlin layers, unless empty
     int RiverNodes;
     int RiverSamples;
     float RiverThickness;
     int RiverSeed;
+    NodeSampler RiverSampler;
+    float RiverMinDistance;             // 0 derives it from RiverNodes
+    NodeRng RiverRng;
+    bool RiverParallelDelaunay;
+    ProximityGraph RiverGraph;
+    int RiverNeighbours;
+    SplineType RiverSpline;
+    int RiverTributaries;
+    float RiverHeightCost;
+    float RiverSlopeCost;
+    bool RiverNarrowBand;
     int GaussKSX;
     int GaussKSY;
     float GaussSigma;
     float PlaneDelta;
     int PlaneWidth;
     int PlaneHeight;
+    ResampleFilter PlaneFilter;
 
     std::string OutHMap;
+    int OutBitDepth;
+    PngOptions Png;
     std::string OutMesh;
+    std::string OutTrace;
+    std::string CacheDir;
 };
 
 
-RiverParams parse_river_params(const std::string& filename);
\ No newline at end of file
+RiverParams parse_river_params(const std::string& filename);
+
+/**
+ * @brief       Parse the parameters from a JSON object. filename only names the
+ *              source in error messages. If RequireOutput is false, the output
+ *              filenames are left empty when "output_file" is missing.
+ */
+RiverParams parse_river_params(const nlohmann::json& j, const std::string& filename, bool RequireOutput = true);
+
+/**
+ * @brief       Parse the attribute "noise_graph" of a configuration. filename
+ *              only names the source in error messages.
+ */
+NoiseGraph parse_noise_graph(const nlohmann::json& j, const std::string& filename);
\ No newline at end of file
@@ -12,7 +12,9 @@
 #pragma once
 
 #include <hmap.hpp>
+#include <resample.hpp>
 #include <string>
 
-void triangulate_plane(const HeightMap& HM, int w, int h, int& ntris, float** verts, unsigned int** tris);
+void triangulate_plane(const HeightMap& HM, int w, int h, int& ntris, float** verts, unsigned int** tris,
+                       ResampleFilter filter = ResampleFilter::Bilinear);
 void export_plane_as_obj(const std::string& filename, int nverts, int ntris, float* verts, unsigned int* tris);
\ No newline at end of file
@@ -0,0 +1,100 @@
+/**
+ * @file        profiler.hpp
+ *
+ * @brief       Lightweight timing and counter instrumentation.
+ *
+ * @details     Pipeline stages are wrapped in RT_PROFILE_SCOPE() and algorithms
+ *              report their work with RT_PROFILE_COUNT(). Both check a single
+ *              atomic flag and do nothing else while the profiler is disabled,
+ *              which is the default. Compiling with RT_DISABLE_PROFILING removes
+ *              them entirely.\n
+ *              The profiler is the only process-wide state of the library, and
+ *              it is thread-safe.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#pragma once
+
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <cstdint>
+
+
+class Profiler
+{
+private:
+    static std::atomic<bool> s_Enabled;
+
+public:
+    static void Enable(bool On = true);
+    static bool IsEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief       Discard every recorded event and counter.
+     */
+    static void Reset();
+
+    /**
+     * @brief       Nanoseconds elapsed since the first use of the profiler.
+     */
+    static uint64_t Now();
+
+    static void Record(const char* Name, uint64_t Begin, uint64_t End);
+    static void AddCounter(const char* Name, int64_t Value);
+
+    /**
+     * @brief       Print per-stage timings (calls, total, mean, max) and the
+     *              value of every counter as a table.
+     */
+    static void PrintSummary(std::ostream& os);
+
+    /**
+     * @brief       Write the recorded events in Chrome trace format, which can be
+     *              loaded in chrome://tracing or in Perfetto.
+     */
+    static void WriteTrace(const std::string& filename);
+};
+
+
+/**
+ * @brief       Records the lifetime of the object as an event named Name.
+ */
+class ProfileScope
+{
+private:
+    const char* m_Name;
+    uint64_t m_Begin;
+    bool m_Active;
+
+public:
+    ProfileScope(const char* Name)
+    {
+        m_Active = Profiler::IsEnabled();
+        m_Name = Name;
+        m_Begin = m_Active ? Profiler::Now() : 0;
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+    ~ProfileScope()
+    {
+        if (m_Active)
+            Profiler::Record(m_Name, m_Begin, Profiler::Now());
+    }
+};
+
+
+#ifdef RT_DISABLE_PROFILING
+#define RT_PROFILE_SCOPE(name) ((void)0)
+#define RT_PROFILE_COUNT(name, value) ((void)0)
+#else
+#define RT_PROFILE_CONCAT_(a, b) a##b
+#define RT_PROFILE_CONCAT(a, b) RT_PROFILE_CONCAT_(a, b)
+#define RT_PROFILE_SCOPE(name) ProfileScope RT_PROFILE_CONCAT(rtProfileScope, __LINE__)(name)
+#define RT_PROFILE_COUNT(name, value) \
+    do { if (Profiler::IsEnabled()) Profiler::AddCounter(name, value); } while (0)
+#endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+/**
+ * @file        resample.hpp
+ *
+ * @brief       Separable resampling of heightmaps.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#pragma once
+
+#include <hmap.hpp>
+#include <string>
+
+
+/**
+ * @brief       Reconstruction filter used when resampling a grid.
+ */
+enum class ResampleFilter
+{
+    Bilinear,
+    Bicubic,            // Catmull-Rom cubic
+    Lanczos3
+};
+
+ResampleFilter parse_resample_filter(const std::string& name);
+
+
+/**
+ * @brief       Resample a SrcW-by-SrcH grid into a DstW-by-DstH grid.
+ *
+ * @details     Both grids are row-major and their corners are aligned, so that
+ *              the first and last samples of each row and column coincide.
+ *              When the destination is smaller than the source along an axis,
+ *              the filter is stretched by the ratio of the sample spacings, so
+ *              that it also acts as a low-pass filter against aliasing.\n
+ *              Tap indices and weights are computed once per output row and
+ *              column, and the filter is applied as a vertical pass over whole
+ *              source rows followed by a horizontal pass, so the cost is linear
+ *              in the output size.
+ *
+ * @param Src       Source grid.
+ * @param SrcW      Source width.
+ * @param SrcH      Source height.
+ * @param Dst       Destination grid, with room for DstW * DstH floats.
+ * @param DstW      Destination width.
+ * @param DstH      Destination height.
+ * @param Filter    Reconstruction filter.
+ */
+void resample(const float* Src, int SrcW, int SrcH,
+              float* Dst, int DstW, int DstH,
+              ResampleFilter Filter = ResampleFilter::Bilinear);
+
+void resample(const HeightMap& HM, float* Dst, int DstW, int DstH,
+              ResampleFilter Filter = ResampleFilter::Bilinear);
\ No newline at end of file
@@ -0,0 +1,81 @@
+/**
+ * @file        rtlib.h
+ *
+ * @brief       C interface of the river terrain generator.
+ *
+ * @details     Thin C wrapper around RiverGenerator, for callers that cannot
+ *              use the C++ API. Functions never throw: failures are reported
+ *              through return codes, and the message of the last failure is
+ *              stored in the generator itself.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#ifndef RTLIB_H
+#define RTLIB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief       Generation parameters. See the configuration file documentation
+ *              for the meaning of each field.
+ */
+typedef struct rt_params
+{
+    int width;
+    int height;
+    float perlin_weight;
+    float perlin_scale;
+    int perlin_octaves;
+    float voronoi_weight;
+    float voronoi_scale;
+    int river_nodes;
+    int river_samples;
+    float river_thickness;
+    int river_seed;
+    int gauss_ksx;
+    int gauss_ksy;
+    float gauss_sigma;
+    float plane_delta;
+} rt_params;
+
+typedef struct rt_generator rt_generator;
+
+
+/**
+ * @brief       Fill params with the values of configs/sample-000.json.
+ */
+void rt_params_default(rt_params* params);
+
+/**
+ * @brief       Create a generator. Returns NULL on failure.
+ */
+rt_generator* rt_generator_create(void);
+
+void rt_generator_destroy(rt_generator* gen);
+
+/**
+ * @brief       Generate a heightmap into out, which must hold
+ *              params->width * params->height floats, in row-major order.
+ *
+ * @return      0 on success, a non-zero value otherwise.
+ */
+int rt_generate(rt_generator* gen, const rt_params* params, float* out);
+
+/**
+ * @brief       Message of the last failure of gen, or an empty string.
+ */
+const char* rt_generator_error(const rt_generator* gen);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTLIB_H
\ No newline at end of file
@@ -0,0 +1,100 @@
+/**
+ * @file        rtlib.hpp
+ *
+ * @brief       In-process river terrain generation API.
+ *
+ * @details     This is the entry point for applications that embed the
+ *              generator. It performs no file I/O and keeps no global state
+ *              besides the optional Profiler: every reusable resource lives in
+ *              a RiverGenerator, and the heightmap is written into memory
+ *              owned by the caller.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#pragma once
+
+#include <parser.hpp>
+#include <hmap.hpp>
+#include <cache.hpp>
+#include <layers.hpp>
+#include <tasks.hpp>
+#include <vector>
+
+
+/**
+ * @brief       Reusable river terrain generator.
+ *
+ * @details     A generator owns the render target used to draw the river and
+ *              the support memory of the blur, and keeps them between calls,
+ *              so that repeated generations of maps with the same size do not
+ *              allocate any map-sized buffer. With a ThreadPool, it also keeps
+ *              the noise layers, which are generated while the river is drawn.\n
+ *              A generator must not be used by more than one thread at a time,
+ *              but distinct generators can run concurrently.
+ */
+class RiverGenerator
+{
+private:
+    sf::RenderTexture m_Canvas;
+    std::vector<float> m_Scratch;
+    HeightMap m_Voronoi;
+    HeightMap m_Perlin;
+    ThreadPool* m_Pool;
+
+    void GenerateBed(const RiverParams& Params, HeightMap& HM, const StageCache* Cache,
+                     const HeightMap* Voronoi, const HeightMap* Perlin);
+    void GenerateLayers(const RiverParams& Params, HeightMap& Bed, HeightMap& Voronoi, HeightMap& Perlin);
+
+public:
+    /**
+     * @brief       Create a generator. If Pool is not nullptr, the independent
+     *              stages run concurrently on it, and the pool must outlive the
+     *              generator.
+     */
+    explicit RiverGenerator(ThreadPool* Pool = nullptr);
+    RiverGenerator(const RiverGenerator&) = delete;
+    RiverGenerator& operator=(const RiverGenerator&) = delete;
+    ~RiverGenerator();
+
+    /**
+     * @brief       Generate the terrain described by Params into HM.
+     *
+     * @details     The size of HM takes precedence over Params.Width and
+     *              Params.Height, and the output fields of Params are ignored.
+     *              The previous contents of HM are discarded.\n
+     *              If Params.CacheDir is not empty, the output of every stage is
+     *              looked up in the cache before being computed, and stored in it
+     *              otherwise. The result is the same as without the cache.
+     *
+     * @throws std::runtime_error on failure.
+     */
+    void Generate(const RiverParams& Params, HeightMap& HM);
+
+    /**
+     * @brief       Generate the terrain described by Params into a caller-owned
+     *              row-major buffer of Params.Width * Params.Height floats.
+     *
+     * @throws std::runtime_error on failure.
+     */
+    void Generate(const RiverParams& Params, float* Out);
+
+    /**
+     * @brief       Generate the unweighted layers described by Params into Stack,
+     *              whose size takes precedence over Params.Width and Params.Height.
+     *
+     * @details     Stack.Compose() then produces the same map as Generate() for
+     *              any noise weights and delta, so that interactive tools can
+     *              change them without running the pipeline again. When the river
+     *              follows the terrain, though, its path depends on the noise
+     *              weights of Params. With a noise graph, its output goes in the
+     *              Perlin layer (see LayerStack).\n
+     *              The cache is used as in Generate().
+     *
+     * @throws std::runtime_error on failure.
+     */
+    void GenerateLayers(const RiverParams& Params, LayerStack& Stack);
+};
\ No newline at end of file
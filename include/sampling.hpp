@@ -0,0 +1,91 @@
+/**
+ * @file        sampling.hpp
+ *
+ * @brief       Point sampling of the unit square.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <string>
+#include <random>
+#include <rng.hpp>
+#include <tasks.hpp>
+
+
+/**
+ * @brief       Distribution of the river's nodes.
+ */
+enum class NodeSampler
+{
+    Uniform,            // Independent uniform points
+    Poisson             // Blue noise, no two points closer than a minimum distance
+};
+
+NodeSampler parse_node_sampler(const std::string& name);
+
+/**
+ * @brief       Random number generator of the river's nodes.
+ */
+enum class NodeRng
+{
+    MT19937,            // One sequential std::mt19937 stream
+    Philox              // Counter-based, node k is a function of the seed and k only
+};
+
+NodeRng parse_node_rng(const std::string& name);
+
+
+/**
+ * @brief       The point of index Index of the unit square, for the given seed.
+ *
+ * @details     Points of distinct domains are independent, so that the same
+ *              seed can sample several sets of points.
+ */
+sf::Vector2f philox_point(uint64_t Seed, uint64_t Index, uint32_t Domain = 0);
+
+/**
+ * @brief       Write the points First, ..., First + Count - 1 of domain 0 to Out,
+ *              splitting large ranges across the threads of Pool, if given.
+ */
+void philox_points(uint64_t Seed, uint64_t First, size_t Count, sf::Vector2f* Out, ThreadPool* Pool = nullptr);
+
+
+/**
+ * @brief       Bridson's Poisson-disk sampling of the unit square.
+ *
+ * @details     Points are added around the active ones, trying Attempts random
+ *              candidates in the annulus between MinDistance and twice as much,
+ *              and a background grid with cells of side MinDistance / sqrt(2)
+ *              holds at most one point per cell, so that every candidate is
+ *              checked against a constant number of points.\n
+ *              Sampling stops when the square is full or MaxPoints points have
+ *              been produced. Since the points grow outwards from the first one,
+ *              in the latter case they only cover part of the square.\n
+ *              Engine can be either std::mt19937 or Philox4x32. Its outputs are
+ *              used without the standard distributions, whose results depend on
+ *              the implementation.
+ */
+template<typename Engine>
+std::vector<sf::Vector2f> poisson_disk(float MinDistance, int MaxPoints, Engine& Eng, int Attempts = 30);
+
+/**
+ * @brief       The minimum distance for which poisson_disk() fills the unit
+ *              square with about Points points.
+ */
+float poisson_disk_distance(int Points);
+
+/**
+ * @brief       An upper bound on the number of points of the unit square that are
+ *              at least MinDistance apart, from the densest packing of discs.
+ *
+ * @details     Passed as MaxPoints, it bounds the memory of poisson_disk()
+ *              without ever cutting the sampling short.
+ */
+int poisson_disk_capacity(float MinDistance);
\ No newline at end of file
@@ -0,0 +1,80 @@
+/**
+ * @file        sfStroke.hpp
+ *
+ * @brief       SFML polylines with varying thickness, drawn in a single call.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+
+/**
+ * @brief       A set of thick polylines, with round joins and end caps, stored
+ *              as the triangles of a single vertex array.
+ *
+ * @details     Each segment is a quad whose width varies linearly between the
+ *              thickness of its ends, and each point after the first is covered
+ *              by a disc as large as its thickness, so that a polyline starts
+ *              with a flat cap. The color of a stroke goes from inCol on
+ *              the center line to outCol on its border. Gamma-corrected gradients
+ *              are split in bands across the width, since vertex colors are
+ *              interpolated linearly.
+ */
+class sfStroke : public sf::Drawable
+{
+protected:
+    sf::VertexArray m_verts;
+    sf::Color m_col1;
+    sf::Color m_col2;
+    bool m_gammaCorr;
+    int m_bands;
+
+    sf::Color Gradient(float t) const;
+    void AddQuad(const sf::Vector2f& a0, const sf::Vector2f& a1,
+                 const sf::Vector2f& b0, const sf::Vector2f& b1,
+                 const sf::Color& c0, const sf::Color& c1);
+    void AddDisc(const sf::Vector2f& center, float radius);
+    void AddSegment(const sf::Vector2f& p0, const sf::Vector2f& p1, float r0, float r1);
+
+public:
+    /**
+     * @brief       An empty stroke of uniform color.
+     */
+    sfStroke(const sf::Color& color = sf::Color(255, 255, 255));
+
+    /**
+     * @brief       An empty stroke going from inCol on the center line to outCol
+     *              on the border.
+     */
+    sfStroke(const sf::Color& inCol,
+             const sf::Color& outCol,
+             bool gammaCorr = true);
+
+    /**
+     * @brief       Append the polyline through points, with thickness[i] at
+     *              points[i].
+     *
+     * @throws std::runtime_error if points and thickness have different sizes.
+     */
+    void Add(const std::vector<sf::Vector2f>& points, const std::vector<float>& thickness);
+
+    /**
+     * @brief       Remove all the polylines.
+     */
+    void Clear();
+
+    /**
+     * @brief       The number of vertices of the triangles of the stroke.
+     */
+    size_t GetVertexCount() const;
+
+    virtual void draw(sf::RenderTarget &target,
+                      const sf::RenderStates& states) const override;
+};
\ No newline at end of file
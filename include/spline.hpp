@@ -13,12 +13,36 @@
 
 #include <SFML/Graphics.hpp>
 #include <Eigen/Dense>
+#include <string>
 
 
+/**
+ * @brief       Kind of curve through the points.
+ */
+enum class SplineType
+{
+    Natural,            // Natural cubic spline, solved over all the points at once
+    CatmullRom          // Centripetal Catmull-Rom, each segment depends on four points
+};
+
+SplineType parse_spline_type(const std::string& name);
 
+
+/**
+ * @brief       A curve through a sequence of points, with parameter in [0, 1).
+ *
+ * @details     The points are evenly spaced in the parameter. A natural spline
+ *              solves one linear system over all of them, so every point moves
+ *              the whole curve. A Catmull-Rom spline is local: the segment between
+ *              two points only depends on them and on their neighbours, and the
+ *              points beyond the ends are mirrored. Long curves can then be
+ *              evaluated one segment at a time with Segment(), without building
+ *              a Spline over all of their points.
+ */
 class Spline
 {
 private:
+    SplineType m_Type;
     Eigen::VectorXf m_T;
     Eigen::VectorXf m_X;
     Eigen::VectorXf m_Y;
@@ -27,7 +51,7 @@ private:
 
 
 public:
-    Spline(const std::vector<sf::Vector2f>& P);
+    Spline(const std::vector<sf::Vector2f>& P, SplineType Type = SplineType::Natural);
     Spline(const Spline& S);
     Spline& operator=(const Spline& S);
     ~Spline();
@@ -35,4 +59,11 @@ public:
 
     sf::Vector2f Evaluate(float t) const;
     sf::Vector2f operator()(float t) const;
+
+    /**
+     * @brief       The point at u in [0, 1] of the centripetal Catmull-Rom segment
+     *              from P1 to P2, where P0 and P3 are the points before and after.
+     */
+    static sf::Vector2f Segment(const sf::Vector2f& P0, const sf::Vector2f& P1, const sf::Vector2f& P2,
+                                const sf::Vector2f& P3, float u);
 };
\ No newline at end of file
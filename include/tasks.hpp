@@ -0,0 +1,149 @@
+/**
+ * @file        tasks.hpp
+ *
+ * @brief       Work-stealing thread pool and dependency graphs of tasks.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <exception>
+
+
+/**
+ * @brief       A fixed set of worker threads, each with its own queue of tasks.
+ *
+ * @details     Tasks submitted by a worker go to the back of its own queue, and
+ *              the worker runs them last-in first-out. Idle workers steal from
+ *              the front of the other queues. Threads that are not workers of
+ *              the pool can help through RunPending() while they wait.
+ */
+class ThreadPool
+{
+private:
+    struct Queue
+    {
+        std::mutex Lock;
+        std::deque<std::function<void()>> Tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_Queues;
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Lock;
+    std::condition_variable m_Wake;
+    std::atomic<int> m_Pending;
+    std::atomic<unsigned int> m_Next;
+    bool m_Stop;
+
+    bool Pop(int Self, std::function<void()>& Task);
+    void Loop(int Self);
+
+public:
+    /**
+     * @brief       Start Threads workers, or one per hardware thread if Threads is 0.
+     */
+    explicit ThreadPool(int Threads = 0);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief       Run the tasks still queued, then join the workers.
+     */
+    ~ThreadPool();
+
+    int GetThreads() const;
+
+    /**
+     * @brief       Queue a task. Tasks must not throw.
+     */
+    void Submit(std::function<void()> Task);
+
+    /**
+     * @brief       Run one queued task on the calling thread.
+     *
+     * @return      false if there was no task to run.
+     */
+    bool RunPending();
+};
+
+
+/**
+ * @brief       A set of tasks and of their dependencies.
+ *
+ * @details     A task starts only after all the tasks it depends on have
+ *              completed, and tasks without a path between them may run
+ *              concurrently. A graph can be run any number of times.
+ */
+class TaskGraph
+{
+private:
+    struct Node
+    {
+        std::function<void()> Fn;
+        std::vector<int> Next;
+        int nDeps = 0;
+        std::atomic<int> Remaining { 0 };
+    };
+
+    std::vector<std::unique_ptr<Node>> m_Nodes;
+    std::mutex m_Lock;
+    std::condition_variable m_Progress;
+    size_t m_Done;
+    std::exception_ptr m_Error;
+    std::atomic<bool> m_Failed;
+
+    void Execute(ThreadPool& Pool, int Task);
+
+public:
+    TaskGraph();
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    /**
+     * @brief       Add a task that runs after the tasks in Deps.
+     *
+     * @return      The identifier of the task, to be used in the dependencies of
+     *              later tasks.
+     *
+     * @throws std::runtime_error if a dependency is not a task of the graph.
+     */
+    int Add(std::function<void()> Fn, const std::vector<int>& Deps = { });
+
+    /**
+     * @brief       Run all the tasks on Pool and wait for them, helping the pool
+     *              meanwhile. If Pool is nullptr, the tasks run in the order they
+     *              were added on the calling thread.
+     *
+     * @details     Once a task throws, the tasks that did not start yet are
+     *              skipped, and the first exception is rethrown after the running
+     *              tasks have completed.
+     */
+    void Run(ThreadPool* Pool);
+};
+
+
+/**
+ * @brief       Call Fn(Begin, End) on consecutive ranges covering [0, Count), run
+ *              as tasks on Pool, and wait for them.
+ *
+ * @details     Ranges hold at least MinChunk items, so that small loops are not
+ *              split, and there is at most one per thread of the pool. Ranges
+ *              start at multiples of Align. Without a pool, or with a single
+ *              range, Fn(0, Count) runs on the calling thread. Since the calling
+ *              thread helps the pool while it waits, this can also be called from
+ *              tasks of Pool. The first exception thrown by Fn is rethrown.
+ */
+void parallel_for(ThreadPool* Pool, size_t Count, size_t MinChunk, const std::function<void(size_t, size_t)>& Fn,
+                  size_t Align = 1);
\ No newline at end of file
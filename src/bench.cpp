@@ -0,0 +1,594 @@
+/**
+ * @file        bench.cpp
+ *
+ * @brief       Benchmark of the RTLib kernels.
+ *
+ * @details     Every kernel is run over a ladder of map sizes (from 256x256) or
+ *              of node counts (from 100), doubling or multiplying by ten at each
+ *              step up to the limits given on the command line. The threaded
+ *              kernels are also run with an increasing number of threads. Where
+ *              the hardware counters can be read (Linux, perf_event_paranoid of 2
+ *              or less), the cache misses of every run are counted as well.\n
+ *              Results are printed as a table and can be saved as JSON. Two
+ *              result files can then be compared to detect regressions.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <geometry.hpp>
+#include <sampling.hpp>
+#include <graph.hpp>
+#include <spline.hpp>
+#include <noises.hpp>
+#include <noise_graph.hpp>
+#include <plane.hpp>
+#include <hmap_io.hpp>
+#include <layers.hpp>
+#include <sfStroke.hpp>
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace
+{
+
+struct BenchOptions
+{
+    int MaxSize = 4096;
+    int MaxNodes = 10000;
+    int MaxThreads = std::max(1u, std::thread::hardware_concurrency());
+    int Repeat = 3;
+    std::string OutFile;
+};
+
+struct BenchResult
+{
+    std::string Kernel;
+    int Size;               // Map side or number of nodes
+    int Threads;
+    double Seconds;         // Median over the repetitions
+    double Throughput;
+    std::string Unit;
+    int64_t CacheMisses;    // Median over the repetitions, -1 if not counted
+};
+
+// A measure of the output of a kernel rather than of its speed
+struct BenchNote
+{
+    std::string Kernel;
+    int Size;
+    std::string Name;
+    double Value;
+};
+
+
+// Cache misses of the calling thread and of the threads it starts meanwhile
+class CacheCounter
+{
+private:
+    int m_Fd;
+
+public:
+    CacheCounter() : m_Fd(-1)
+    {
+#ifdef __linux__
+        perf_event_attr Attr;
+        std::memset(&Attr, 0, sizeof(Attr));
+        Attr.type = PERF_TYPE_HARDWARE;
+        Attr.size = sizeof(Attr);
+        Attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        Attr.disabled = 1;
+        Attr.inherit = 1;
+        Attr.exclude_kernel = 1;
+        Attr.exclude_hv = 1;
+        m_Fd = (int)syscall(SYS_perf_event_open, &Attr, 0, -1, -1, 0);
+#endif
+    }
+    CacheCounter(const CacheCounter&) = delete;
+    CacheCounter& operator=(const CacheCounter&) = delete;
+
+    ~CacheCounter()
+    {
+#ifdef __linux__
+        if (m_Fd >= 0)
+            close(m_Fd);
+#endif
+    }
+
+    bool Available() const { return m_Fd >= 0; }
+
+    void Start()
+    {
+#ifdef __linux__
+        if (m_Fd >= 0)
+        {
+            ioctl(m_Fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_Fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    int64_t Stop()
+    {
+        int64_t Count = -1;
+#ifdef __linux__
+        if (m_Fd >= 0)
+        {
+            ioctl(m_Fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(m_Fd, &Count, sizeof(Count)) != sizeof(Count))
+                Count = -1;
+        }
+#endif
+        return Count;
+    }
+};
+
+
+class Bench
+{
+private:
+    BenchOptions m_Opts;
+    std::vector<BenchResult> m_Results;
+    std::vector<BenchNote> m_Notes;
+    CacheCounter m_Misses;
+
+public:
+    Bench(const BenchOptions& Opts) : m_Opts(Opts) { }
+
+    const std::vector<BenchResult>& Results() const { return m_Results; }
+    const std::vector<BenchNote>& Notes() const { return m_Notes; }
+
+    // Time Fn and record Work / seconds as throughput, in millions of Unit per second
+    void Run(const std::string& Kernel, int Size, int Threads, double Work, const std::string& Unit,
+             const std::function<void()>& Fn)
+    {
+        std::vector<double> Times;
+        std::vector<int64_t> Misses;
+        for (int r = 0; r < m_Opts.Repeat; ++r)
+        {
+            m_Misses.Start();
+            auto t0 = std::chrono::steady_clock::now();
+            Fn();
+            auto t1 = std::chrono::steady_clock::now();
+            Misses.push_back(m_Misses.Stop());
+            Times.push_back(std::chrono::duration<double>(t1 - t0).count());
+        }
+        std::sort(Times.begin(), Times.end());
+        std::sort(Misses.begin(), Misses.end());
+        double Seconds = Times[Times.size() / 2];
+
+        BenchResult R = { Kernel, Size, Threads, Seconds, Work / Seconds * 1e-6, "M" + Unit + "/s",
+                          Misses[Misses.size() / 2] };
+        std::cout << std::left << std::setw(24) << R.Kernel
+                  << std::right << std::setw(10) << R.Size
+                  << std::setw(9) << R.Threads
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(14) << R.Seconds * 1e3
+                  << std::setw(14) << R.Throughput << ' ' << std::left << std::setw(10) << R.Unit
+                  << std::right << std::defaultfloat;
+        if (R.CacheMisses >= 0)
+            std::cout << std::setw(14) << R.CacheMisses;
+        std::cout << std::endl;
+        m_Results.push_back(R);
+    }
+
+    void Note(const std::string& Kernel, int Size, const std::string& Name, double Value)
+    {
+        std::cout << std::left << std::setw(24) << Kernel
+                  << std::right << std::setw(10) << Size
+                  << "    " << Name << " = " << Value << std::endl;
+        m_Notes.push_back({ Kernel, Size, Name, Value });
+    }
+};
+
+
+std::vector<sf::Vector2f> sample_points(int n)
+{
+    // Same layout used by river(): n inner points plus a source and a target
+    std::mt19937 Eng(0);
+    std::uniform_real_distribution<float> Dist(0.0f, 1.0f);
+    std::vector<sf::Vector2f> P;
+    P.reserve(n + 2);
+    for (int i = 0; i < n; ++i)
+        P.emplace_back(Dist(Eng), Dist(Eng));
+    P.emplace_back(Dist(Eng), -0.1f);
+    P.emplace_back(Dist(Eng), 1.1f);
+    return P;
+}
+
+HeightMap bench_map(int s)
+{
+    HeightMap HM(s, s);
+    add_perlin(HM, 1.0f, 5.0f, 4);
+    return HM;
+}
+
+// The default noise layers, 0.8 Perlin plus 0.4 Voronoi, as a graph, optionally warped
+NoiseGraph bench_noise_graph(bool Warp)
+{
+    NoiseGraph G;
+    NoiseNode N;
+    N.Op = NoiseOp::FBM;
+    N.Scale = 5.0f;
+    N.Octaves = 6;
+    int Perlin = G.Add(N);
+    N = NoiseNode();
+    N.Op = NoiseOp::Cellular;
+    N.Scale = 6.0f;
+    int Voronoi = G.Add(N);
+    int Terms[2];
+    const float Weights[2] = { 0.8f, 0.4f };
+    for (int k = 0; k < 2; ++k)
+    {
+        N = NoiseNode();
+        N.Value = Weights[k];
+        N.B = G.Add(N);
+        N.Op = NoiseOp::Mul;
+        N.A = k == 0 ? Perlin : Voronoi;
+        Terms[k] = G.Add(N);
+    }
+    N = NoiseNode();
+    N.Op = NoiseOp::Add;
+    N.A = Terms[0];
+    N.B = Terms[1];
+    int Out = G.Add(N);
+    if (Warp)
+    {
+        N = NoiseNode();
+        N.Op = NoiseOp::Warp;
+        N.A = Out;
+        N.Amount = 0.05f;
+        N.Scale = 2.0f;
+        N.Octaves = 2;
+        Out = G.Add(N);
+    }
+    G.SetOutput(Out);
+    return G;
+}
+
+
+void bench_graphs(Bench& B, const BenchOptions& Opts)
+{
+    HeightMap Relief = bench_map(1024);
+    for (int n = 100; n <= Opts.MaxNodes; n *= 10)
+    {
+        auto P = sample_points(n);
+        std::set<std::pair<int, int>> E;
+        B.Run("delaunay", n, 1, n, "pts", [&]() { E = delaunay(P); });
+        for (int t = 1; t <= Opts.MaxThreads; t *= 2)
+        {
+            ThreadPool Pool(t);
+            B.Run("delaunay_parallel", n, t, n, "pts", [&]() { delaunay_parallel(P, &Pool); });
+        }
+        std::vector<sf::Vector2f> Q(n);
+        B.Run("philox_points", n, 1, n, "pts", [&]() { philox_points(0, 0, n, Q.data()); });
+        B.Run("poisson_disk", n, 1, n, "pts", [&]()
+        {
+            std::mt19937 Eng(0);
+            poisson_disk(poisson_disk_distance(n), n, Eng);
+        });
+
+        Graph G(P, E);
+        B.Run("graph", n, 1, E.size(), "edges", [&]() { Graph G2(P, E); });
+        B.Run("graph_hilbert", n, 1, E.size(), "edges", [&]() { Graph G2(P, E, VertexOrder::Hilbert); });
+
+        // Same search on the vertices in sampling order and along the curves
+        Path Pth;
+        B.Run("shortest_path", n, 1, E.size(), "edges", [&]() { Pth = G.ShortestPath(n, n + 1); });
+        Graph GM(P, E, VertexOrder::Morton);
+        B.Run("shortest_path_morton", n, 1, E.size(), "edges", [&]() { GM.ShortestPath(n, n + 1); });
+        Graph GH(P, E, VertexOrder::Hilbert);
+        B.Run("shortest_path_hilbert", n, 1, E.size(), "edges", [&]() { GH.ShortestPath(n, n + 1); });
+        B.Run("shortest_path_tree", n, 1, E.size(), "edges", [&]() { G.ShortestPathTree(n + 1); });
+
+        // Costs of the edges over a terrain, as when the river follows the valleys
+        std::vector<std::pair<int, int>> EV(E.begin(), E.end());
+        for (int t = 1; t <= Opts.MaxThreads; t *= 2)
+        {
+            ThreadPool Pool(t);
+            B.Run("edge_costs", n, t, EV.size(), "edges", [&]()
+            {
+                terrain_edge_costs(Relief, P, EV, 4.0f, 20.0f, 8, &Pool);
+            });
+        }
+
+        // Sparser graphs: time to build them, then how much longer they make the path
+        std::vector<std::pair<int, int>> EG, ER, EK;
+        B.Run("gabriel", n, 1, EV.size(), "edges", [&]() { EG = gabriel_graph(P, EV); });
+        B.Run("rng", n, 1, EV.size(), "edges", [&]() { ER = relative_neighbourhood_graph(P, EV); });
+        for (int t = 1; t <= Opts.MaxThreads; t *= 2)
+        {
+            ThreadPool Pool(t);
+            B.Run("knn", n, t, n, "pts", [&]() { EK = knn_graph(P, 8, &Pool); });
+        }
+        for (auto Sparse : { std::make_pair("gabriel", &EG), std::make_pair("rng", &ER), std::make_pair("knn", &EK) })
+        {
+            Graph GS(P, *Sparse.second);
+            B.Note(Sparse.first, n, "edges", Sparse.second->size() / (double)EV.size());
+            B.Note(Sparse.first, n, "path_stretch", GS.ShortestPath(n, n + 1).Length / Pth.Length);
+        }
+
+        // The spline is built on the river path, as in the pipeline
+        std::vector<sf::Vector2f> Nodes;
+        for (int i : Pth.Nodes)
+            Nodes.push_back(P[i]);
+        int nn = Nodes.size();
+        const int nEvals = 100000;
+        for (auto Type : { std::make_pair("", SplineType::Natural), std::make_pair("_catmull_rom", SplineType::CatmullRom) })
+        {
+            std::string Suffix = Type.first;
+            B.Run("spline_build" + Suffix, n, 1, nn, "nodes", [&]() { Spline S(Nodes, Type.second); });
+
+            Spline S(Nodes, Type.second);
+            B.Run("spline_eval" + Suffix, n, 1, nEvals, "evals", [&]()
+            {
+                sf::Vector2f Acc(0.0f, 0.0f);
+                for (int i = 0; i < nEvals; ++i)
+                    Acc += S(i / (float)nEvals);
+                volatile float Sink = Acc.x + Acc.y;
+                (void)Sink;
+            });
+        }
+    }
+}
+
+
+void bench_maps(Bench& B, const BenchOptions& Opts)
+{
+    std::filesystem::path Dir = std::filesystem::temp_directory_path();
+    for (int s = 256; s <= Opts.MaxSize; s *= 2)
+    {
+        double Pixels = (double)s * s;
+        HeightMap HM = bench_map(s);
+
+        std::vector<float> Scratch(gauss_blur_scratch_size(s, s, 60, 60));
+        B.Run("gauss_blur", s, 1, Pixels, "px", [&]() { gauss_blur(HM, 60, 60, 10.0f, Scratch.data()); });
+        B.Run("add_perlin", s, 1, Pixels, "px", [&]() { add_perlin(HM, 0.8f, 5.0f, 6); });
+        B.Run("add_perlin_multires", s, 1, Pixels, "px", [&]() { add_perlin(HM, 0.8f, 5.0f, 6, true); });
+        B.Run("add_voronoi", s, 1, Pixels, "px", [&]() { add_voronoi(HM, 0.4f, 6.0f); });
+        B.Run("add_spectral", s, 1, Pixels, "px", [&]() { add_spectral(HM, 0.4f, 2.0f, 1); });
+        NoiseGraph Graph = bench_noise_graph(false);
+        NoiseGraph Warped = bench_noise_graph(true);
+        B.Run("noise_graph", s, 1, Pixels, "px", [&]() { Graph.Evaluate(HM); });
+        B.Run("noise_graph_warp", s, 1, Pixels, "px", [&]() { Warped.Evaluate(HM); });
+
+        // A meandering river across the map, one point every other pixel
+        int nPts = s / 2;
+        std::vector<sf::Vector2f> Line(nPts);
+        std::vector<float> Widths(nPts);
+        for (int i = 0; i < nPts; ++i)
+        {
+            float t = i / (float)(nPts - 1);
+            Line[i] = sf::Vector2f(s * (0.5f + 0.3f * std::sin(12.0f * t)), s * t);
+            Widths[i] = 4.0f + 12.0f * t;
+        }
+        sfStroke Stroke;
+        B.Run("stroke", s, 1, nPts, "pts", [&]()
+        {
+            Stroke.Clear();
+            Stroke.Add(Line, Widths);
+        });
+        B.Note("stroke", s, "vertices", (double)Stroke.GetVertexCount());
+
+        // The band of the same river that a 60-pixel blur can reach
+        RowSpans Band;
+        Band.Rows.resize(s + 1);
+        for (int j = 0; j < s; ++j)
+        {
+            float x = s * (0.5f + 0.3f * std::sin(12.0f * j / (float)(s - 1)));
+            Band.Rows[j + 1] = j + 1;
+            Band.Spans.emplace_back(std::max(0, (int)x - 76), std::min(s, (int)x + 76));
+        }
+        B.Run("gauss_blur_band", s, 1, Pixels, "px", [&]() { gauss_blur(HM, Band, 60, 60, 10.0f, Scratch.data()); });
+
+        LayerStack Stack(s, s);
+        Stack.Bed() = HM;
+        Stack.Voronoi() = HM;
+        Stack.Perlin() = HM;
+        HeightMap Composed(s, s);
+        B.Run("compose_layers", s, 1, Pixels, "px", [&]() { Stack.Compose(0.4f, 0.8f, 3.0f, Composed); });
+
+        B.Run("triangulate_plane", s, 1, Pixels, "verts", [&]()
+        {
+            int ntris;
+            float* verts;
+            unsigned int* tris;
+            triangulate_plane(HM, s, s, ntris, &verts, &tris);
+            std::free(verts);
+            std::free(tris);
+        });
+
+        // Exporters
+        std::string Base = (Dir / "river-bench").string();
+        for (int t = 1; t <= Opts.MaxThreads; t *= 2)
+        {
+            PngOptions Png;
+            Png.Threads = t;
+            B.Run("export_png8", s, t, Pixels, "px", [&]() { export_hmap_png(Base + ".png", HM, 8, Png); });
+            B.Run("export_png16", s, t, Pixels, "px", [&]() { export_hmap_png(Base + ".png", HM, 16, Png); });
+        }
+        B.Run("export_r16", s, 1, Pixels, "px", [&]() { export_hmap_r16(Base + ".r16", HM); });
+        B.Run("export_r32", s, 1, Pixels, "px", [&]() { export_hmap_r32(Base + ".r32", HM); });
+        B.Run("export_tiff", s, 1, Pixels, "px", [&]() { export_hmap_tiff(Base + ".tif", HM); });
+        for (const char* Ext : { ".png", ".r16", ".r32", ".tif" })
+            std::filesystem::remove(Base + Ext);
+    }
+}
+
+
+void save_results(const std::string& filename, const std::vector<BenchResult>& Results,
+                  const std::vector<BenchNote>& Notes)
+{
+    nlohmann::json j;
+    j["results"] = nlohmann::json::array();
+    for (const auto& R : Results)
+    {
+        j["results"].push_back({ { "kernel", R.Kernel }, { "size", R.Size }, { "threads", R.Threads },
+                                 { "seconds", R.Seconds }, { "throughput", R.Throughput }, { "unit", R.Unit },
+                                 { "cache_misses", R.CacheMisses } });
+    }
+    j["notes"] = nlohmann::json::array();
+    for (const auto& N : Notes)
+        j["notes"].push_back({ { "kernel", N.Kernel }, { "size", N.Size }, { "name", N.Name }, { "value", N.Value } });
+
+    std::ofstream of;
+    of.open(filename, std::ios::out);
+    if (!of.is_open())
+    {
+        std::stringstream ss;
+        ss << "Cannot open file " << filename << " for writing.";
+        throw std::runtime_error(ss.str());
+    }
+    of << j.dump(2);
+    of.close();
+}
+
+nlohmann::json load_results(const std::string& filename)
+{
+    std::ifstream f(filename);
+    if (!f.is_open())
+    {
+        std::stringstream ss;
+        ss << "Cannot open file " << filename << " for reading.";
+        throw std::runtime_error(ss.str());
+    }
+    nlohmann::json j = nlohmann::json::parse(f);
+    if (!j.contains("results") || !j["results"].is_array())
+    {
+        std::stringstream ss;
+        ss << "File " << filename << " does not contain benchmark results.";
+        throw std::runtime_error(ss.str());
+    }
+    return j;
+}
+
+
+// Returns the number of regressions, i.e. runs slower than the baseline by more than Tolerance
+int compare_results(const std::string& BaseFile, const std::string& NewFile, double Tolerance)
+{
+    nlohmann::json Base = load_results(BaseFile);
+    nlohmann::json New = load_results(NewFile);
+
+    int nRegressions = 0;
+    std::cout << std::left << std::setw(24) << "Kernel"
+              << std::right << std::setw(10) << "Size"
+              << std::setw(9) << "Threads"
+              << std::setw(14) << "Base (ms)"
+              << std::setw(14) << "New (ms)"
+              << std::setw(10) << "Ratio" << std::endl;
+    for (const auto& N : New["results"])
+    {
+        auto it = std::find_if(Base["results"].begin(), Base["results"].end(), [&N](const nlohmann::json& b)
+        {
+            return b["kernel"] == N["kernel"] && b["size"] == N["size"] && b["threads"] == N["threads"];
+        });
+        if (it == Base["results"].end())
+            continue;
+        double tb = (*it)["seconds"];
+        double tn = N["seconds"];
+        double Ratio = tn / tb;
+        bool Regressed = Ratio > 1.0 + Tolerance;
+        nRegressions += Regressed;
+        std::cout << std::left << std::setw(24) << N["kernel"].get<std::string>()
+                  << std::right << std::setw(10) << N["size"].get<int>()
+                  << std::setw(9) << N["threads"].get<int>()
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(14) << tb * 1e3
+                  << std::setw(14) << tn * 1e3
+                  << std::setw(10) << Ratio
+                  << std::defaultfloat << (Regressed ? "  REGRESSION" : "") << std::endl;
+    }
+    std::cout << nRegressions << " regression(s) with tolerance " << Tolerance * 100 << "%." << std::endl;
+    return nRegressions;
+}
+
+
+void usage()
+{
+    std::cerr << "Usage:" << std::endl;
+    std::cerr << "    RiverBench [--max-size N] [--max-nodes N] [--max-threads N] [--repeat N] [--out results.json]" << std::endl;
+    std::cerr << "    RiverBench --compare base.json new.json [--tolerance 0.1]" << std::endl;
+}
+
+} // namespace
+
+
+int main(int argc, const char* const argv[])
+{
+    BenchOptions Opts;
+    std::string CompareBase, CompareNew;
+    double Tolerance = 0.1;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string Arg = argv[i];
+        bool HasValue = i + 1 < argc;
+        if (Arg == "--max-size" && HasValue)
+            Opts.MaxSize = std::atoi(argv[++i]);
+        else if (Arg == "--max-nodes" && HasValue)
+            Opts.MaxNodes = std::atoi(argv[++i]);
+        else if (Arg == "--max-threads" && HasValue)
+            Opts.MaxThreads = std::max(1, std::atoi(argv[++i]));
+        else if (Arg == "--repeat" && HasValue)
+            Opts.Repeat = std::max(1, std::atoi(argv[++i]));
+        else if (Arg == "--out" && HasValue)
+            Opts.OutFile = argv[++i];
+        else if (Arg == "--tolerance" && HasValue)
+            Tolerance = std::atof(argv[++i]);
+        else if (Arg == "--compare" && i + 2 < argc)
+        {
+            CompareBase = argv[++i];
+            CompareNew = argv[++i];
+        }
+        else
+        {
+            usage();
+            return -1;
+        }
+    }
+
+    try
+    {
+        if (!CompareBase.empty())
+            return compare_results(CompareBase, CompareNew, Tolerance) > 0 ? 1 : 0;
+
+        std::cout << std::left << std::setw(24) << "Kernel"
+                  << std::right << std::setw(10) << "Size"
+                  << std::setw(9) << "Threads"
+                  << std::setw(14) << "Time (ms)"
+                  << std::setw(14) << "Throughput"
+                  << std::setw(25) << "Cache misses" << std::endl;
+        Bench B(Opts);
+        bench_graphs(B, Opts);
+        bench_maps(B, Opts);
+        if (!Opts.OutFile.empty())
+            save_results(Opts.OutFile, B.Results(), B.Notes());
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return -1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+/**
+ * @file        cache.cpp
+ *
+ * @brief       Implements StageKey and StageCache.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <cache.hpp>
+#include <profiler.hpp>
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <random>
+#include <cstring>
+
+
+namespace
+{
+
+// Bump when the output of any stage changes, to invalidate existing caches
+const uint32_t CacheVersion = 1;
+
+const uint64_t FNVOffset = 14695981039346656037ull;
+const uint64_t FNVPrime = 1099511628211ull;
+
+} // namespace
+
+
+StageKey::StageKey(const std::string& Stage)
+{
+    m_Hash = FNVOffset;
+    Add(CacheVersion);
+    Add(Stage.data(), Stage.size());
+}
+
+StageKey& StageKey::Add(const void* Data, size_t n)
+{
+    const unsigned char* p = (const unsigned char*)Data;
+    for (size_t i = 0; i < n; ++i)
+    {
+        m_Hash ^= p[i];
+        m_Hash *= FNVPrime;
+    }
+    return *this;
+}
+
+uint64_t StageKey::Value() const { return m_Hash; }
+
+
+
+StageCache::StageCache(const std::string& Dir)
+{
+    m_Dir = Dir;
+    std::error_code Err;
+    std::filesystem::create_directories(Dir, Err);
+    if (!std::filesystem::is_directory(Dir))
+    {
+        std::stringstream ss;
+        ss << "Cannot create cache directory " << Dir << '.';
+        throw std::runtime_error(ss.str());
+    }
+}
+
+
+std::string StageCache::Filename(const std::string& Stage, uint64_t Key) const
+{
+    std::stringstream ss;
+    ss << Stage << '-' << std::hex << std::setw(16) << std::setfill('0') << Key << ".bin";
+    return (std::filesystem::path(m_Dir) / ss.str()).string();
+}
+
+
+bool StageCache::Open(const std::string& Stage, uint64_t Key, uint32_t ElemSize, std::ifstream& f, RecordHeader& H) const
+{
+    f.open(Filename(Stage, Key), std::ios::in | std::ios::binary);
+    bool Valid = f.is_open() &&
+                 f.read((char*)&H, sizeof(H)) &&
+                 std::memcmp(H.Magic, "RTSC", 4) == 0 &&
+                 H.Version == CacheVersion &&
+                 H.Key == Key &&
+                 H.ElemSize == ElemSize;
+    // Truncated or foreign files are treated as misses, and overwritten later
+    RT_PROFILE_COUNT(Valid ? "cache.hits" : "cache.misses", 1);
+    return Valid;
+}
+
+
+void StageCache::Write(const std::string& Stage, uint64_t Key, uint32_t ElemSize, const void* Data, uint64_t Count,
+                       float Min, float Max) const
+{
+    RecordHeader H;
+    std::memset(&H, 0, sizeof(H));
+    std::memcpy(H.Magic, "RTSC", 4);
+    H.Version = CacheVersion;
+    H.Key = Key;
+    H.ElemSize = ElemSize;
+    H.Count = Count;
+    H.Min = Min;
+    H.Max = Max;
+
+    // Write to a temporary file and move it in place, so that concurrent
+    // generations sharing the cache never read a partial record
+    std::string Final = Filename(Stage, Key);
+    std::stringstream Tmp;
+    Tmp << Final << '.' << std::hex << std::random_device()() << ".tmp";
+
+    std::ofstream of;
+    of.open(Tmp.str(), std::ios::out | std::ios::binary);
+    if (!of.is_open())
+    {
+        std::stringstream ss;
+        ss << "Cannot open file " << Tmp.str() << " for writing.";
+        throw std::runtime_error(ss.str());
+    }
+    of.write((const char*)&H, sizeof(H));
+    of.write((const char*)Data, Count * ElemSize);
+    of.close();
+    if (!of)
+    {
+        std::filesystem::remove(Tmp.str());
+        std::stringstream ss;
+        ss << "Cannot write cache file " << Final << '.';
+        throw std::runtime_error(ss.str());
+    }
+    std::filesystem::rename(Tmp.str(), Final);
+}
+
+
+bool StageCache::Load(const std::string& Stage, uint64_t Key, HeightMap& HM) const
+{
+    std::ifstream f;
+    RecordHeader H;
+    if (!Open(Stage, Key, sizeof(float), f, H))
+        return false;
+    if (H.Count != (uint64_t)HM.GetWidth() * HM.GetHeight())
+        return false;
+
+    // Read into a buffer first, so that a truncated file leaves HM untouched
+    std::vector<float> Data(H.Count);
+    if (!f.read((char*)Data.data(), H.Count * sizeof(float)))
+        return false;
+    std::copy(Data.begin(), Data.end(), HM.RawData());
+    // All values lie in [Min, Max], so this only restores the range
+    HM.Clamp(H.Min, H.Max);
+    return true;
+}
+
+void StageCache::Store(const std::string& Stage, uint64_t Key, const HeightMap& HM) const
+{
+    Write(Stage, Key, sizeof(float), HM.RawData(), (uint64_t)HM.GetWidth() * HM.GetHeight(), HM.GetMin(), HM.GetMax());
+}
\ No newline at end of file
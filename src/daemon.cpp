@@ -0,0 +1,439 @@
+/**
+ * @file        daemon.cpp
+ *
+ * @brief       Implements the generation daemon.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <daemon.hpp>
+#include <rtlib.hpp>
+#include <parser.hpp>
+#include <hmap_io.hpp>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+#include <csignal>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#endif
+
+
+#ifndef _WIN32
+namespace
+{
+
+// Requests longer than this are rejected, and the connection closed
+const size_t MaxRequestBytes = 1 << 20;
+// Latency percentiles are computed over this many most recent generations
+const size_t MaxLatencySamples = 10000;
+// Blocking calls wake up this often to check for shutdown
+const int PollMillis = 200;
+
+std::atomic<bool> s_Stop { false };
+
+void on_signal(int) { s_Stop = true; }
+
+
+class LatencyStats
+{
+private:
+    std::mutex m_Lock;
+    std::vector<double> m_Samples;
+    size_t m_Next = 0;
+    uint64_t m_Requests = 0;
+    uint64_t m_Errors = 0;
+    std::chrono::steady_clock::time_point m_Start = std::chrono::steady_clock::now();
+
+public:
+    void Record(double Millis, bool Ok)
+    {
+        std::lock_guard<std::mutex> Guard(m_Lock);
+        m_Requests++;
+        m_Errors += !Ok;
+        if (m_Samples.size() < MaxLatencySamples)
+            m_Samples.push_back(Millis);
+        else
+            m_Samples[m_Next] = Millis;
+        m_Next = (m_Next + 1) % MaxLatencySamples;
+    }
+
+    nlohmann::json Report()
+    {
+        std::vector<double> S;
+        nlohmann::json j;
+        {
+            std::lock_guard<std::mutex> Guard(m_Lock);
+            S = m_Samples;
+            j["requests"] = m_Requests;
+            j["errors"] = m_Errors;
+        }
+        j["uptime_s"] = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+
+        nlohmann::json& L = j["latency_ms"];
+        L["samples"] = S.size();
+        if (S.empty())
+            return j;
+        std::sort(S.begin(), S.end());
+        double Sum = 0.0;
+        for (double s : S)
+            Sum += s;
+        auto Percentile = [&S](double p) { return S[std::min(S.size() - 1, (size_t)(p * S.size()))]; };
+        L["mean"] = Sum / S.size();
+        L["p50"] = Percentile(0.50);
+        L["p90"] = Percentile(0.90);
+        L["p99"] = Percentile(0.99);
+        L["max"] = S.back();
+        return j;
+    }
+};
+
+
+// A request line read by the acceptor, to be answered by a worker
+struct Request
+{
+    int Fd;
+    std::string Line;
+};
+
+// The state of an open connection, owned by the acceptor
+struct Connection
+{
+    std::string Pending;
+    // A request of the connection is being served, so it is not polled until the reply is sent
+    bool Busy = false;
+};
+
+
+class RequestQueue
+{
+private:
+    std::mutex m_Lock;
+    std::condition_variable m_Ready;
+    std::deque<Request> m_Requests;
+    bool m_Closed = false;
+
+public:
+    void Push(Request R)
+    {
+        {
+            std::lock_guard<std::mutex> Guard(m_Lock);
+            m_Requests.push_back(std::move(R));
+        }
+        m_Ready.notify_one();
+    }
+
+    // Returns false once the queue is closed
+    bool Pop(Request& R)
+    {
+        std::unique_lock<std::mutex> Guard(m_Lock);
+        m_Ready.wait(Guard, [this]() { return m_Closed || !m_Requests.empty(); });
+        if (m_Closed)
+            return false;
+        R = std::move(m_Requests.front());
+        m_Requests.pop_front();
+        return true;
+    }
+
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> Guard(m_Lock);
+            m_Closed = true;
+            m_Requests.clear();
+        }
+        m_Ready.notify_all();
+    }
+};
+
+
+// Connections whose reply has been sent, handed back by the workers to the acceptor
+class ReplyQueue
+{
+private:
+    std::mutex m_Lock;
+    std::vector<std::pair<int, bool>> m_Done;
+    int m_Wake[2] = { -1, -1 };
+
+public:
+    ReplyQueue()
+    {
+        if (pipe(m_Wake) != 0)
+            throw std::runtime_error("Cannot create the pipe of the daemon.");
+        for (int fd : m_Wake)
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    ~ReplyQueue()
+    {
+        close(m_Wake[0]);
+        close(m_Wake[1]);
+    }
+
+    // Readable whenever some connection has been handed back
+    int WakeFd() const { return m_Wake[0]; }
+
+    void Push(int fd, bool Sent)
+    {
+        {
+            std::lock_guard<std::mutex> Guard(m_Lock);
+            m_Done.emplace_back(fd, Sent);
+        }
+        // A full pipe already wakes the acceptor
+        char c = 0;
+        (void)!write(m_Wake[1], &c, 1);
+    }
+
+    std::vector<std::pair<int, bool>> Take()
+    {
+        char Drain[256];
+        while (read(m_Wake[0], Drain, sizeof(Drain)) > 0) { }
+        std::lock_guard<std::mutex> Guard(m_Lock);
+        return std::move(m_Done);
+    }
+};
+
+
+bool send_all(int fd, const void* Data, size_t n)
+{
+    const char* p = (const char*)Data;
+    while (n > 0)
+    {
+        ssize_t Sent = send(fd, p, n, 0);
+        if (Sent <= 0)
+            return false;
+        p += Sent;
+        n -= Sent;
+    }
+    return true;
+}
+
+
+// Answer one request, returning false if the reply could not be sent
+bool serve(int fd, const std::string& Line, RiverGenerator& Gen, std::vector<float>& Buffer, LatencyStats& Stats)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    nlohmann::json Reply;
+    const void* Payload = nullptr;
+    size_t PayloadSize = 0;
+    bool IsGenerate = false;
+    try
+    {
+        nlohmann::json Req = nlohmann::json::parse(Line);
+        std::string Cmd = Req.value("command", "");
+        if (Cmd == "generate")
+        {
+            IsGenerate = true;
+            if (!Req.contains("params") || !Req["params"].is_object())
+                throw std::runtime_error("Request must contain the object \"params\".");
+            std::string Mode = Req.value("reply", "bytes");
+            if (Mode != "bytes" && Mode != "file")
+                throw std::runtime_error("Attribute \"reply\" must be either \"bytes\" or \"file\".");
+
+            RiverParams Params = parse_river_params(Req["params"], "<request>", Mode == "file");
+            if (Params.Width < 2 || Params.Height < 2)
+                throw std::runtime_error("Heightmaps must be at least 2-by-2.");
+            size_t n = (size_t)Params.Width * Params.Height;
+            if (Buffer.size() < n)
+                Buffer.resize(n);
+            HeightMap HM(Params.Width, Params.Height, Buffer.data());
+            Gen.Generate(Params, HM);
+
+            Reply = { { "status", "ok" }, { "width", Params.Width }, { "height", Params.Height },
+                      { "min", HM.GetMin() }, { "max", HM.GetMax() } };
+            if (Mode == "bytes")
+            {
+                Payload = Buffer.data();
+                PayloadSize = n * sizeof(float);
+                Reply["bytes"] = PayloadSize;
+            }
+            else
+                Reply["path"] = export_hmap(Params.OutHMap, HM, Params.OutBitDepth, Params.Png);
+        }
+        else if (Cmd == "stats")
+        {
+            Reply = Stats.Report();
+            Reply["status"] = "ok";
+        }
+        else if (Cmd == "shutdown")
+        {
+            s_Stop = true;
+            Reply = { { "status", "ok" } };
+        }
+        else
+            throw std::runtime_error("Unknown command \"" + Cmd + "\".");
+    }
+    catch(const std::exception& e)
+    {
+        Reply = { { "status", "error" }, { "message", e.what() } };
+        Payload = nullptr;
+    }
+
+    std::string Head = Reply.dump() + '\n';
+    bool Sent = send_all(fd, Head.data(), Head.size()) &&
+                (Payload == nullptr || send_all(fd, Payload, PayloadSize));
+    if (IsGenerate)
+    {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        Stats.Record(ms, Reply["status"] == "ok");
+    }
+    return Sent;
+}
+
+
+// Queue the next complete request of a connection, if it has one and none is being served
+void dispatch(int fd, Connection& C, RequestQueue& Queue)
+{
+    if (C.Busy)
+        return;
+    size_t End = C.Pending.find('\n');
+    if (End == std::string::npos)
+        return;
+    Request R { fd, C.Pending.substr(0, End) };
+    C.Pending.erase(0, End + 1);
+    C.Busy = true;
+    Queue.Push(std::move(R));
+}
+
+} // namespace
+#endif
+
+
+void run_daemon(const std::string& SocketPath, int Workers)
+{
+#ifdef _WIN32
+    throw std::runtime_error("The daemon requires Unix domain sockets, which are not available on this platform.");
+#else
+    sockaddr_un Addr = { };
+    Addr.sun_family = AF_UNIX;
+    if (SocketPath.size() >= sizeof(Addr.sun_path))
+    {
+        std::stringstream ss;
+        ss << "Socket path " << SocketPath << " is too long.";
+        throw std::runtime_error(ss.str());
+    }
+    SocketPath.copy(Addr.sun_path, SocketPath.size());
+
+    // Only stale sockets are replaced, never regular files
+    std::error_code Err;
+    if (std::filesystem::is_socket(SocketPath, Err))
+        std::filesystem::remove(SocketPath, Err);
+
+    int Listen = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (Listen < 0 || bind(Listen, (const sockaddr*)&Addr, sizeof(Addr)) != 0 || listen(Listen, 64) != 0)
+    {
+        if (Listen >= 0)
+            close(Listen);
+        std::stringstream ss;
+        ss << "Cannot listen on socket " << SocketPath << '.';
+        throw std::runtime_error(ss.str());
+    }
+
+    s_Stop = false;
+    auto OldInt = std::signal(SIGINT, on_signal);
+    auto OldTerm = std::signal(SIGTERM, on_signal);
+    auto OldPipe = std::signal(SIGPIPE, SIG_IGN);
+
+    if (Workers <= 0)
+        Workers = std::max(1u, std::thread::hardware_concurrency());
+    LatencyStats Stats;
+    RequestQueue Queue;
+    ReplyQueue Replies;
+    std::vector<std::thread> Pool;
+    for (int i = 0; i < Workers; ++i)
+    {
+        Pool.emplace_back([&Queue, &Replies, &Stats]()
+        {
+            RiverGenerator Gen;
+            std::vector<float> Buffer;
+            Request R;
+            while (Queue.Pop(R))
+                Replies.Push(R.Fd, serve(R.Fd, R.Line, Gen, Buffer, Stats));
+        });
+    }
+
+    // The acceptor owns all connections and reads their requests, so that workers only
+    // spend time on complete requests and idle clients never hold one
+    std::unordered_map<int, Connection> Conns;
+    auto Drop = [&Conns](int fd) { close(fd); Conns.erase(fd); };
+    std::vector<pollfd> Polled;
+    char Chunk[4096];
+    while (!s_Stop)
+    {
+        Polled.clear();
+        Polled.push_back({ Listen, POLLIN, 0 });
+        Polled.push_back({ Replies.WakeFd(), POLLIN, 0 });
+        for (auto& [fd, C] : Conns)
+            if (!C.Busy)
+                Polled.push_back({ fd, POLLIN, 0 });
+        if (poll(Polled.data(), Polled.size(), PollMillis) <= 0)
+            continue;
+
+        for (auto [fd, Sent] : Replies.Take())
+        {
+            if (!Sent)
+            {
+                Drop(fd);
+                continue;
+            }
+            Connection& C = Conns[fd];
+            C.Busy = false;
+            dispatch(fd, C, Queue);
+        }
+
+        for (size_t i = 2; i < Polled.size(); ++i)
+        {
+            if (Polled[i].revents == 0)
+                continue;
+            int fd = Polled[i].fd;
+            ssize_t n = recv(fd, Chunk, sizeof(Chunk), 0);
+            if (n <= 0)
+            {
+                Drop(fd);
+                continue;
+            }
+            Connection& C = Conns[fd];
+            C.Pending.append(Chunk, n);
+            dispatch(fd, C, Queue);
+            if (!C.Busy && C.Pending.size() > MaxRequestBytes)
+                Drop(fd);
+        }
+
+        if (Polled[0].revents & POLLIN)
+        {
+            int fd = accept(Listen, nullptr, nullptr);
+            if (fd >= 0)
+                Conns[fd];
+        }
+    }
+
+    Queue.Close();
+    for (auto& t : Pool)
+        t.join();
+    for (auto& [fd, C] : Conns)
+        close(fd);
+    close(Listen);
+    std::filesystem::remove(SocketPath, Err);
+
+    std::signal(SIGINT, OldInt);
+    std::signal(SIGTERM, OldTerm);
+    std::signal(SIGPIPE, OldPipe);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,307 @@
+/**
+ * @file        deflate.cpp
+ *
+ * @brief       Implements a minimal deflate encoder.
+ *
+ * @details     The encoder only emits fixed-Huffman and stored blocks, which is
+ *              what stb_image_write does as well, but it is chunk-oriented so
+ *              that large images can be compressed in bands.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <deflate.hpp>
+#include <algorithm>
+
+
+namespace
+{
+
+const int LenBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                          35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const int LenExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                           3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const int DistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                           257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                           8193, 12289, 16385, 24577 };
+const int DistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// Hash chain length for each compression level
+const int ChainLength[10] = { 0, 4, 8, 16, 32, 64, 128, 256, 1024, 4096 };
+
+const int WindowSize = 32768;
+const int MinMatch = 3;
+const int MaxMatch = 258;
+const int HashBits = 15;
+
+
+struct CrcTable
+{
+    uint32_t T[256];
+    CrcTable()
+    {
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            T[n] = c;
+        }
+    }
+};
+const CrcTable Crc;
+
+
+uint32_t reverse_bits(uint32_t code, int len)
+{
+    uint32_t r = 0;
+    for (int i = 0; i < len; ++i, code >>= 1)
+        r = (r << 1) | (code & 1);
+    return r;
+}
+
+
+/**
+ * Fixed Huffman codes, already bit-reversed so that they can be written
+ * LSB-first like every other field of the stream.
+ */
+struct FixedCodes
+{
+    uint16_t Lit[288];
+    uint8_t LitLen[288];
+    uint8_t Dist[30];
+
+    FixedCodes()
+    {
+        for (int v = 0; v < 288; ++v)
+        {
+            if (v < 144)        { Lit[v] = reverse_bits(0x30 + v, 8); LitLen[v] = 8; }
+            else if (v < 256)   { Lit[v] = reverse_bits(0x190 + v - 144, 9); LitLen[v] = 9; }
+            else if (v < 280)   { Lit[v] = reverse_bits(v - 256, 7); LitLen[v] = 7; }
+            else                { Lit[v] = reverse_bits(0xC0 + v - 280, 8); LitLen[v] = 8; }
+        }
+        for (int d = 0; d < 30; ++d)
+            Dist[d] = reverse_bits(d, 5);
+    }
+};
+const FixedCodes Fixed;
+
+
+class BitWriter
+{
+private:
+    std::vector<unsigned char>& m_Out;
+    uint64_t m_Buf;
+    int m_Count;
+
+public:
+    BitWriter(std::vector<unsigned char>& Out) : m_Out(Out), m_Buf(0), m_Count(0) { }
+
+    void Put(uint32_t bits, int n)
+    {
+        m_Buf |= (uint64_t)bits << m_Count;
+        m_Count += n;
+        while (m_Count >= 8)
+        {
+            m_Out.push_back(m_Buf & 0xFF);
+            m_Buf >>= 8;
+            m_Count -= 8;
+        }
+    }
+
+    void Align()
+    {
+        if (m_Count > 0)
+            Put(0, 8 - m_Count);
+    }
+};
+
+
+void put_literal(BitWriter& BW, int v)
+{
+    BW.Put(Fixed.Lit[v], Fixed.LitLen[v]);
+}
+
+void put_match(BitWriter& BW, int len, int dist)
+{
+    int lc = 28;
+    while (LenBase[lc] > len)
+        --lc;
+    put_literal(BW, 257 + lc);
+    BW.Put(len - LenBase[lc], LenExtra[lc]);
+
+    int dc = 29;
+    while (DistBase[dc] > dist)
+        --dc;
+    BW.Put(Fixed.Dist[dc], 5);
+    BW.Put(dist - DistBase[dc], DistExtra[dc]);
+}
+
+// Empty stored block: pads the stream to a byte boundary without terminating it
+void put_sync(BitWriter& BW)
+{
+    BW.Put(0, 3);
+    BW.Align();
+    BW.Put(0x0000, 16);
+    BW.Put(0xFFFF, 16);
+}
+
+uint32_t hash3(const unsigned char* p)
+{
+    uint32_t h = (p[0] << 16) | (p[1] << 8) | p[2];
+    return (h * 2654435761u) >> (32 - HashBits);
+}
+
+} // namespace
+
+
+uint32_t crc32(uint32_t crc, const unsigned char* data, size_t n)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i)
+        crc = Crc.T[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint32_t adler32(uint32_t adler, const unsigned char* data, size_t n)
+{
+    const uint32_t Base = 65521;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (n > 0)
+    {
+        // 5552 is the largest block that cannot overflow b
+        size_t blk = std::min<size_t>(n, 5552);
+        n -= blk;
+        for (size_t i = 0; i < blk; ++i)
+        {
+            a += data[i];
+            b += a;
+        }
+        data += blk;
+        a %= Base;
+        b %= Base;
+    }
+    return (b << 16) | a;
+}
+
+uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2)
+{
+    const uint32_t Base = 65521;
+    uint32_t rem = len2 % Base;
+    uint32_t sum1 = adler1 & 0xFFFF;
+    uint32_t sum2 = (uint32_t)(((uint64_t)rem * sum1) % Base);
+    sum1 += (adler2 & 0xFFFF) + Base - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + Base - rem;
+    if (sum1 >= Base) sum1 -= Base;
+    if (sum1 >= Base) sum1 -= Base;
+    if (sum2 >= 2 * Base) sum2 -= 2 * Base;
+    if (sum2 >= Base) sum2 -= Base;
+    return (sum2 << 16) | sum1;
+}
+
+
+void deflate_chunk(const unsigned char* data, size_t n, int level, std::vector<unsigned char>& out)
+{
+    level = std::min(9, std::max(0, level));
+    BitWriter BW(out);
+
+    if (level == 0 || n < MinMatch)
+    {
+        size_t pos = 0;
+        do
+        {
+            size_t blk = std::min<size_t>(n - pos, 65535);
+            BW.Put(0, 3);
+            BW.Align();
+            BW.Put(blk, 16);
+            BW.Put(~blk & 0xFFFF, 16);
+            out.insert(out.end(), data + pos, data + pos + blk);
+            pos += blk;
+        } while (pos < n);
+        return;
+    }
+
+    // One fixed-Huffman block for the whole chunk
+    BW.Put(0, 1);
+    BW.Put(1, 2);
+
+    int MaxChain = ChainLength[level];
+    std::vector<int> Head(1 << HashBits, -1);
+    std::vector<int> Prev(n, -1);
+
+    size_t i = 0;
+    while (i < n)
+    {
+        int BestLen = 0;
+        int BestDist = 0;
+        if (i + MinMatch <= n)
+        {
+            uint32_t h = hash3(data + i);
+            int MaxLen = (int)std::min<size_t>(MaxMatch, n - i);
+            int chain = MaxChain;
+            for (int c = Head[h]; c >= 0 && i - c <= WindowSize && chain-- > 0; c = Prev[c])
+            {
+                const unsigned char* a = data + c;
+                const unsigned char* b = data + i;
+                if (a[BestLen] != b[BestLen])
+                    continue;
+                int len = 0;
+                while (len < MaxLen && a[len] == b[len])
+                    ++len;
+                if (len > BestLen)
+                {
+                    BestLen = len;
+                    BestDist = i - c;
+                    if (len == MaxLen)
+                        break;
+                }
+            }
+        }
+
+        int Advance = BestLen >= MinMatch ? BestLen : 1;
+        if (BestLen >= MinMatch)
+            put_match(BW, BestLen, BestDist);
+        else
+            put_literal(BW, data[i]);
+
+        // Insert every consumed position into the hash chains
+        for (int k = 0; k < Advance; ++k, ++i)
+        {
+            if (i + MinMatch > n)
+                continue;
+            uint32_t h = hash3(data + i);
+            Prev[i] = Head[h];
+            Head[h] = i;
+        }
+    }
+    put_literal(BW, 256);
+    put_sync(BW);
+}
+
+
+void zlib_header(int level, std::vector<unsigned char>& out)
+{
+    // CMF: deflate with 32K window. FLG: level hint, no dictionary, FCHECK
+    unsigned char cmf = 0x78;
+    unsigned char lvl = level <= 1 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+    unsigned char flg = lvl << 6;
+    flg += 31 - ((cmf * 256 + flg) % 31);
+    out.push_back(cmf);
+    out.push_back(flg);
+}
+
+void zlib_trailer(uint32_t adler, std::vector<unsigned char>& out)
+{
+    // Empty fixed-Huffman final block
+    out.push_back(0x03);
+    out.push_back(0x00);
+    out.push_back(adler >> 24);
+    out.push_back((adler >> 16) & 0xFF);
+    out.push_back((adler >> 8) & 0xFF);
+    out.push_back(adler & 0xFF);
+}
\ No newline at end of file
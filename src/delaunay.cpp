@@ -10,6 +10,7 @@
  * @date        2023-08-24
  */
 #include <geometry.hpp>
+#include <profiler.hpp>
 #include <unordered_map>
 #include <map>
 #include <unordered_set>
@@ -102,6 +103,8 @@ bool operator!=(const Triangle& T1, const Triangle& T2)
 
 std::set<std::pair<int, int>> delaunay(const std::vector<sf::Vector2f>& PP)
 {
+    RT_PROFILE_SCOPE("delaunay");
+    int64_t Tested = 0;
     std::vector<sf::Vector2f> P = PP;
     int nPts = P.size();
     std::unordered_set<Triangle, TriHash> Tris;
@@ -122,6 +125,7 @@ std::set<std::pair<int, int>> delaunay(const std::vector<sf::Vector2f>& PP)
         const auto& p = P[i];
         std::unordered_set<Triangle, TriHash> Bad;
 
+        Tested += Tris.size();
         for (const auto& T : Tris)
         {
             // Find circumcenter and radius squared
@@ -167,6 +171,8 @@ std::set<std::pair<int, int>> delaunay(const std::vector<sf::Vector2f>& PP)
         }
     }
 
+    RT_PROFILE_COUNT("delaunay.triangles_tested", Tested);
+
     // Convert to set of ordered pairs
     std::set<std::pair<int, int>> Edges;
     for (const auto& T : Tris)
@@ -0,0 +1,606 @@
+/**
+ * @file        delaunay_parallel.cpp
+ *
+ * @brief       Implements the parallel Delaunay triangulation.
+ *
+ * @details     delaunay() triangulates the points together with the vertices of
+ *              a fixed super triangle, and drops the triangles that touch them.
+ *              The same triangulation is computed here in blocks of a grid: each
+ *              block triangulates its points and a halo of neighbouring points
+ *              (plus the outer layer of all the points, if the block lies on it,
+ *              since thin triangles get long there), and keeps the triangles whose
+ *              lowest vertex lies in the block and whose circumcircle is empty. A
+ *              circumcircle that lies inside the gathered region is empty if it is
+ *              empty of the gathered points; the others are checked against all.
+ *              delaunay() decides with float arithmetic, and here predicates are
+ *              evaluated in double, so nearly degenerate triangles (mostly the
+ *              ones touching the super triangle) can be flipped between the two.\n
+ *              Kept triangles are Delaunay, and distinct by construction, so the
+ *              triangulation is complete when their number and the number of
+ *              their edges match Euler's formula. Otherwise (too thin halos, or
+ *              cocircular points triangulated differently by two blocks) the
+ *              halos are enlarged, and eventually delaunay() is called instead.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <geometry.hpp>
+#include <profiler.hpp>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+
+namespace
+{
+
+struct DPoint
+{
+    double x, y;
+};
+
+// Positive if a, b, c are in counter-clockwise order
+double orient(const DPoint& a, const DPoint& b, const DPoint& c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// Positive if d lies inside the circumcircle of the counter-clockwise triangle a, b, c
+double incircle(const DPoint& a, const DPoint& b, const DPoint& c, const DPoint& d)
+{
+    double adx = a.x - d.x, ady = a.y - d.y;
+    double bdx = b.x - d.x, bdy = b.y - d.y;
+    double cdx = c.x - d.x, cdy = c.y - d.y;
+    double ad = adx * adx + ady * ady;
+    double bd = bdx * bdx + bdy * bdy;
+    double cd = cdx * cdx + cdy * cdy;
+    return adx * (bdy * cd - bd * cdy) - ady * (bdx * cd - bd * cdx) + ad * (bdx * cdy - bdy * cdx);
+}
+
+void circumcircle(const DPoint& a, const DPoint& b, const DPoint& c, double& ux, double& uy, double& r)
+{
+    double bx = b.x - a.x, by = b.y - a.y;
+    double cx = c.x - a.x, cy = c.y - a.y;
+    double b2 = bx * bx + by * by;
+    double c2 = cx * cx + cy * cy;
+    double d = 2.0 * (bx * cy - cx * by);
+    double x = (b2 * cy - c2 * by) / d;
+    double y = (c2 * bx - b2 * cx) / d;
+    r = std::sqrt(x * x + y * y);
+    ux = a.x + x;
+    uy = a.y + y;
+}
+
+// The super triangle of delaunay()
+const DPoint Super[3] = { { -0.5, -0.5 }, { 2.5, -0.5 }, { -0.5, 2.5 } };
+
+bool inside_super(const sf::Vector2f& p)
+{
+    return p.x > -0.5f && p.y > -0.5f && p.x + p.y < 2.0f;
+}
+
+
+/**
+ * Bowyer-Watson triangulation of a set of points inside the super triangle,
+ * which is kept as a part of the triangulation. Points are located by walking
+ * from the last created triangle, and the cavity of a new point is grown from
+ * the triangle containing it through the adjacency.
+ */
+class LocalDelaunay
+{
+private:
+    struct Tri
+    {
+        int v[3];           // Counter-clockwise
+        int n[3];           // n[i] is across the edge opposite to v[i], -1 if none
+    };
+
+    std::vector<DPoint> m_P;
+    std::vector<Tri> m_T;
+    std::vector<int> m_Mark;
+    std::vector<int> m_Free;
+    std::vector<int> m_Cavity;
+    std::vector<int> m_Stack;
+    std::vector<int> m_First;
+    int m_Stamp;
+    int m_Last;
+
+    int Locate(const DPoint& p) const
+    {
+        int t = m_Last;
+        int Start = 0;
+        // Each step gets strictly closer to p, but a rotating first edge also
+        // keeps the walk from cycling on round-off
+        for (size_t Steps = 0; Steps < 4 * m_T.size() + 16; ++Steps)
+        {
+            const Tri& T = m_T[t];
+            int Next = -1;
+            for (int k = 0; k < 3; ++k)
+            {
+                int i = (Start + k) % 3;
+                if (orient(m_P[T.v[(i + 1) % 3]], m_P[T.v[(i + 2) % 3]], p) < 0.0)
+                {
+                    // Outside of the super triangle
+                    if (T.n[i] < 0)
+                        return -1;
+                    Next = T.n[i];
+                    break;
+                }
+            }
+            if (Next < 0)
+                return t;
+            t = Next;
+            Start = (Start + 1) % 3;
+        }
+        return -1;
+    }
+
+    int NewTri()
+    {
+        if (!m_Free.empty())
+        {
+            int t = m_Free.back();
+            m_Free.pop_back();
+            return t;
+        }
+        m_T.emplace_back();
+        m_Mark.push_back(0);
+        return (int)m_T.size() - 1;
+    }
+
+    bool Insert(int pi)
+    {
+        const DPoint& p = m_P[pi];
+        int t0 = Locate(p);
+        if (t0 < 0)
+            return false;
+
+        // The cavity is the connected set of triangles whose circumcircle contains p
+        m_Stamp++;
+        m_Cavity.clear();
+        m_Stack.clear();
+        m_Mark[t0] = m_Stamp;
+        m_Stack.push_back(t0);
+        while (!m_Stack.empty())
+        {
+            int t = m_Stack.back();
+            m_Stack.pop_back();
+            m_Cavity.push_back(t);
+            for (int i = 0; i < 3; ++i)
+            {
+                int nb = m_T[t].n[i];
+                if (nb < 0 || m_Mark[nb] == m_Stamp)
+                    continue;
+                const Tri& N = m_T[nb];
+                if (incircle(m_P[N.v[0]], m_P[N.v[1]], m_P[N.v[2]], p) > 0.0)
+                {
+                    m_Mark[nb] = m_Stamp;
+                    m_Stack.push_back(nb);
+                }
+            }
+        }
+
+        // Collect the boundary of the cavity before its triangles are reused
+        m_Stack.clear();
+        for (int t : m_Cavity)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                int nb = m_T[t].n[i];
+                if (nb >= 0 && m_Mark[nb] == m_Stamp)
+                    continue;
+                m_Stack.push_back(m_T[t].v[(i + 1) % 3]);
+                m_Stack.push_back(m_T[t].v[(i + 2) % 3]);
+                m_Stack.push_back(nb);
+            }
+        }
+        for (int t : m_Cavity)
+            m_Free.push_back(t);
+
+        // Fan the boundary edges (a, b) around p
+        size_t nNew = m_Stack.size() / 3;
+        size_t First = m_Cavity.size();
+        m_Cavity.resize(First + nNew);
+        for (size_t e = 0; e < nNew; ++e)
+        {
+            int a = m_Stack[3 * e];
+            int b = m_Stack[3 * e + 1];
+            int nb = m_Stack[3 * e + 2];
+            int t = NewTri();
+            m_Mark[t] = 0;
+            m_T[t].v[0] = a;
+            m_T[t].v[1] = b;
+            m_T[t].v[2] = pi;
+            m_T[t].n[2] = nb;
+            if (nb >= 0)
+            {
+                for (int i = 0; i < 3; ++i)
+                {
+                    Tri& N = m_T[nb];
+                    if (N.v[(i + 1) % 3] == b && N.v[(i + 2) % 3] == a)
+                        N.n[i] = t;
+                }
+            }
+            m_First[a] = t;
+            m_Cavity[First + e] = t;
+        }
+        for (size_t e = 0; e < nNew; ++e)
+        {
+            int t = m_Cavity[First + e];
+            int b = m_T[t].v[1];
+            int Next = m_First[b];
+            m_T[t].n[0] = Next;
+            m_T[Next].n[1] = t;
+        }
+        m_Last = m_Cavity[First];
+        return true;
+    }
+
+public:
+    /**
+     * Triangulate Pts, whose last three points must be the super triangle.
+     * Returns false if a point could not be located.
+     */
+    bool Build(std::vector<DPoint>&& Pts)
+    {
+        m_P = std::move(Pts);
+        int n = (int)m_P.size() - 3;
+        m_T.clear();
+        m_Mark.clear();
+        m_Free.clear();
+        m_First.assign(m_P.size(), -1);
+        m_Stamp = 0;
+
+        Tri T;
+        T.v[0] = n;
+        T.v[1] = n + 1;
+        T.v[2] = n + 2;
+        T.n[0] = T.n[1] = T.n[2] = -1;
+        m_T.push_back(T);
+        m_Mark.push_back(0);
+        m_Last = 0;
+
+        for (int i = 0; i < n; ++i)
+        {
+            if (!Insert(i))
+                return false;
+        }
+        // Dead triangles are the free ones
+        for (int t : m_Free)
+            m_Mark[t] = -1;
+        return true;
+    }
+
+    // Call f(v0, v1, v2) for every triangle, in counter-clockwise order
+    template<typename F>
+    void ForEach(F f) const
+    {
+        for (size_t t = 0; t < m_T.size(); ++t)
+        {
+            if (m_Mark[t] >= 0)
+                f(m_T[t].v[0], m_T[t].v[1], m_T[t].v[2]);
+        }
+    }
+
+    const DPoint& Point(int i) const { return m_P[i]; }
+};
+
+
+// Uniform grid over the bounding box of the points, in compressed row storage
+struct PointGrid
+{
+    double x0, y0, Side;
+    int nx, ny;
+    std::vector<int> Start;
+    std::vector<int> Ids;
+    std::vector<int> CellOf;
+
+    PointGrid(const std::vector<DPoint>& P, double PointsPerCell)
+    {
+        double x1 = x0 = P[0].x;
+        double y1 = y0 = P[0].y;
+        for (const auto& p : P)
+        {
+            x0 = std::min(x0, p.x);
+            x1 = std::max(x1, p.x);
+            y0 = std::min(y0, p.y);
+            y1 = std::max(y1, p.y);
+        }
+        double Area = std::max((x1 - x0) * (y1 - y0), 1e-12);
+        Side = std::sqrt(Area * PointsPerCell / P.size());
+        Side = std::max(Side, std::max(x1 - x0, y1 - y0) / 4096.0);
+        nx = std::max(1, (int)std::ceil((x1 - x0) / Side));
+        ny = std::max(1, (int)std::ceil((y1 - y0) / Side));
+
+        Start.assign((size_t)nx * ny + 1, 0);
+        CellOf.resize(P.size());
+        for (size_t i = 0; i < P.size(); ++i)
+        {
+            int ci = std::min(nx - 1, (int)((P[i].x - x0) / Side));
+            int cj = std::min(ny - 1, (int)((P[i].y - y0) / Side));
+            CellOf[i] = cj * nx + ci;
+            Start[CellOf[i] + 1]++;
+        }
+        for (size_t c = 0; c < (size_t)nx * ny; ++c)
+            Start[c + 1] += Start[c];
+        Ids.resize(P.size());
+        std::vector<int> Fill(Start.begin(), Start.end() - 1);
+        for (size_t i = 0; i < P.size(); ++i)
+            Ids[Fill[CellOf[i]]++] = (int)i;
+    }
+};
+
+
+// Whether no point of P, nor of the super triangle, lies inside the circumcircle of a, b, c
+bool globally_empty(const std::vector<DPoint>& P, const PointGrid& G, int a, int b, int c,
+                    const DPoint& A, const DPoint& B, const DPoint& C)
+{
+    for (int k = 0; k < 3; ++k)
+    {
+        if (incircle(A, B, C, Super[k]) > 0.0)
+            return false;
+    }
+
+    double ux, uy, r;
+    circumcircle(A, B, C, ux, uy, r);
+    if (!std::isfinite(r))
+        return false;
+    int j0 = std::max(0, (int)std::floor((uy - r - G.y0) / G.Side));
+    int j1 = std::min(G.ny - 1, (int)std::floor((uy + r - G.y0) / G.Side));
+    for (int j = j0; j <= j1; ++j)
+    {
+        // Only the cells crossed by the chord of the circle on this row
+        double ry0 = G.y0 + j * G.Side;
+        double ry1 = ry0 + G.Side;
+        double dy = std::max(0.0, std::max(ry0 - uy, uy - ry1));
+        if (dy >= r)
+            continue;
+        double hw = std::sqrt(r * r - dy * dy);
+        int i0 = std::max(0, (int)std::floor((ux - hw - G.x0) / G.Side));
+        int i1 = std::min(G.nx - 1, (int)std::floor((ux + hw - G.x0) / G.Side));
+        for (int i = i0; i <= i1; ++i)
+        {
+            int Cell = j * G.nx + i;
+            for (int k = G.Start[Cell]; k < G.Start[Cell + 1]; ++k)
+            {
+                int q = G.Ids[k];
+                if (q != a && q != b && q != c && incircle(A, B, C, P[q]) > 0.0)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+// The outer layer of the occupied cells, D cells deep along every row and column
+struct Boundary
+{
+    std::vector<char> IsBand;
+    std::vector<int> Cells;         // Row by row
+
+    Boundary(const PointGrid& G, int D)
+    {
+        std::vector<int> RowFirst(G.ny, G.nx), RowLast(G.ny, -1);
+        std::vector<int> ColFirst(G.nx, G.ny), ColLast(G.nx, -1);
+        for (int j = 0; j < G.ny; ++j)
+        {
+            for (int i = 0; i < G.nx; ++i)
+            {
+                int Cell = j * G.nx + i;
+                if (G.Start[Cell] == G.Start[Cell + 1])
+                    continue;
+                RowFirst[j] = std::min(RowFirst[j], i);
+                RowLast[j] = std::max(RowLast[j], i);
+                ColFirst[i] = std::min(ColFirst[i], j);
+                ColLast[i] = std::max(ColLast[i], j);
+            }
+        }
+
+        IsBand.assign((size_t)G.nx * G.ny, 0);
+        for (int j = 0; j < G.ny; ++j)
+        {
+            for (int i = 0; i < G.nx; ++i)
+            {
+                bool Row = i < RowFirst[j] + D || i > RowLast[j] - D;
+                bool Col = j < ColFirst[i] + D || j > ColLast[i] - D;
+                int Cell = j * G.nx + i;
+                if ((Row || Col) && G.Start[Cell] != G.Start[Cell + 1])
+                {
+                    IsBand[Cell] = 1;
+                    Cells.push_back(Cell);
+                }
+            }
+        }
+    }
+};
+
+
+struct BlockResult
+{
+    std::vector<int> Tris;          // Triplets of global indices, counter-clockwise
+    bool Ok = true;
+};
+
+// Triangulate block (bi, bj) of B-by-B grid cells with a halo of H cells
+void triangulate_block(const std::vector<DPoint>& P, const PointGrid& G, const Boundary& Bd, int B, int H,
+                       int bi, int bj, LocalDelaunay& DT, BlockResult& R)
+{
+    int nPts = (int)P.size();
+    int ci0 = bi * B, ci1 = std::min(G.nx, ci0 + B);
+    int cj0 = bj * B, cj1 = std::min(G.ny, cj0 + B);
+    int gi0 = std::max(0, ci0 - H), gi1 = std::min(G.nx, ci1 + H);
+    int gj0 = std::max(0, cj0 - H), gj1 = std::min(G.ny, cj1 + H);
+
+    // All the points in the gathered region are known, and there are none
+    // outside of the grid, so its sides on the border of the grid are open
+    const double Inf = std::numeric_limits<double>::infinity();
+    double bx0 = gi0 == 0 ? -Inf : G.x0 + gi0 * G.Side;
+    double bx1 = gi1 == G.nx ? Inf : G.x0 + gi1 * G.Side;
+    double by0 = gj0 == 0 ? -Inf : G.y0 + gj0 * G.Side;
+    double by1 = gj1 == G.ny ? Inf : G.y0 + gj1 * G.Side;
+
+    // Points are inserted row by row, alternating direction, so that walks are short
+    std::vector<int> Local;
+    auto Gather = [&](int i, int j)
+    {
+        int Cell = j * G.nx + i;
+        Local.insert(Local.end(), G.Ids.begin() + G.Start[Cell], G.Ids.begin() + G.Start[Cell + 1]);
+    };
+    for (int j = gj0; j < gj1; ++j)
+    {
+        bool Forward = (j - gj0) % 2 == 0;
+        for (int s = gi0; s < gi1; ++s)
+            Gather(Forward ? s : gi1 - 1 - (s - gi0), j);
+    }
+
+    // Along the boundary of the points circumcircles are large, and thin triangles
+    // join points that are far apart, so blocks on the boundary also gather the
+    // whole boundary layer
+    bool OnBoundary = false;
+    for (int j = cj0; j < cj1 && !OnBoundary; ++j)
+    {
+        for (int i = ci0; i < ci1 && !OnBoundary; ++i)
+            OnBoundary = Bd.IsBand[j * G.nx + i];
+    }
+    for (int Cell : Bd.Cells)
+    {
+        int i = Cell % G.nx;
+        int j = Cell / G.nx;
+        if (OnBoundary && (i < gi0 || i >= gi1 || j < gj0 || j >= gj1))
+            Gather(i, j);
+    }
+    std::vector<DPoint> LP;
+    LP.reserve(Local.size() + 3);
+    for (int q : Local)
+        LP.push_back(P[q]);
+    LP.insert(LP.end(), Super, Super + 3);
+    int nLocal = (int)Local.size();
+    if (!DT.Build(std::move(LP)))
+    {
+        R.Ok = false;
+        return;
+    }
+
+    auto Global = [&](int v) { return v < nLocal ? Local[v] : nPts + (v - nLocal); };
+    DT.ForEach([&](int a, int b, int c)
+    {
+        // The owner is the block of the lowest vertex, and the super triangle has the highest
+        int ga = Global(a), gb = Global(b), gc = Global(c);
+        int Low = std::min(ga, std::min(gb, gc));
+        if (Low >= nPts)
+            return;
+        int Cell = G.CellOf[Low];
+        int ci = Cell % G.nx;
+        int cj = Cell / G.nx;
+        if (ci < ci0 || ci >= ci1 || cj < cj0 || cj >= cj1)
+            return;
+
+        const DPoint& A = DT.Point(a);
+        const DPoint& Bp = DT.Point(b);
+        const DPoint& C = DT.Point(c);
+        double ux, uy, r;
+        circumcircle(A, Bp, C, ux, uy, r);
+        bool Inside = ux - r > bx0 && ux + r < bx1 && uy - r > by0 && uy + r < by1;
+        if (!Inside && !globally_empty(P, G, ga, gb, gc, A, Bp, C))
+            return;
+        R.Tris.push_back(ga);
+        R.Tris.push_back(gb);
+        R.Tris.push_back(gc);
+    });
+}
+
+} // namespace
+
+
+std::set<std::pair<int, int>> delaunay_parallel(const std::vector<sf::Vector2f>& PP, ThreadPool* Pool)
+{
+    RT_PROFILE_SCOPE("delaunay_parallel");
+    int nPts = (int)PP.size();
+    // Points outside of the super triangle are triangulated however delaunay() does it
+    if (nPts < 3 || !std::all_of(PP.begin(), PP.end(), inside_super))
+        return delaunay(PP);
+
+    std::vector<DPoint> P(nPts);
+    for (int i = 0; i < nPts; ++i)
+        P[i] = { (double)PP[i].x, (double)PP[i].y };
+    PointGrid G(P, 2.0);
+
+    int Threads = Pool != nullptr ? Pool->GetThreads() : 1;
+    // Blocks of about 2048 points, and at least a few per thread
+    const int BlockCells = 32;
+    int B = BlockCells;
+    while (B > 4 && ((G.nx + B - 1) / B) * ((G.ny + B - 1) / B) < 4 * Threads)
+        B /= 2;
+    int nbx = (G.nx + B - 1) / B;
+    int nby = (G.ny + B - 1) / B;
+
+    // A triangulation of N points, 3 of which on the hull (the super triangle),
+    // has 2N - 5 triangles and 3N - 6 edges
+    size_t N = (size_t)nPts + 3;
+    for (int Round = 0, H = 4; Round < 3; ++Round, H *= 2)
+    {
+        Boundary Bd(G, H / 2);
+        std::vector<BlockResult> Results((size_t)nbx * nby);
+        std::atomic<int> Next(0);
+        auto Work = [&]()
+        {
+            LocalDelaunay DT;
+            for (int b = Next++; b < (int)Results.size(); b = Next++)
+                triangulate_block(P, G, Bd, B, H, b % nbx, b / nbx, DT, Results[b]);
+        };
+        // Blocks are taken one at a time, since their costs vary with the density of the points
+        TaskGraph Tasks;
+        for (int t = 0; t < std::min(Threads, (int)Results.size()); ++t)
+            Tasks.Add(Work);
+        Tasks.Run(Pool);
+
+        size_t nTris = 0;
+        bool Ok = true;
+        for (const auto& R : Results)
+        {
+            nTris += R.Tris.size() / 3;
+            Ok = Ok && R.Ok;
+        }
+        RT_PROFILE_COUNT("delaunay_parallel.rounds", 1);
+        if (!Ok || nTris != 2 * N - 5)
+            continue;
+
+        // Every edge is shared by two triangles, except for the hull edges
+        std::vector<std::pair<int, int>> E;
+        E.reserve(3 * nTris);
+        for (const auto& R : Results)
+        {
+            for (size_t t = 0; t < R.Tris.size(); t += 3)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    int a = R.Tris[t + k];
+                    int b = R.Tris[t + (k + 1) % 3];
+                    E.emplace_back(std::min(a, b), std::max(a, b));
+                }
+            }
+        }
+        std::sort(E.begin(), E.end());
+        E.erase(std::unique(E.begin(), E.end()), E.end());
+        if (E.size() != 3 * N - 6)
+            continue;
+
+        // Drop the edges of the super triangle, as delaunay() does
+        std::set<std::pair<int, int>> Edges;
+        for (const auto& e : E)
+        {
+            if (e.second < nPts)
+                Edges.emplace_hint(Edges.end(), e);
+        }
+        return Edges;
+    }
+
+    RT_PROFILE_COUNT("delaunay_parallel.fallbacks", 1);
+    return delaunay(PP);
+}
\ No newline at end of file
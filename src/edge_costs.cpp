@@ -0,0 +1,179 @@
+/**
+ * @file        edge_costs.cpp
+ *
+ * @brief       Implements the terrain-aware costs of the edges of the river graph.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <geometry.hpp>
+#include <profiler.hpp>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RT_EDGE_COSTS_SSE2
+#endif
+
+
+namespace
+{
+
+// Bilinear height at the pixel coordinates (fx, fy), already clamped to the map
+float sample_height(const float* H, int w, int h, float fx, float fy)
+{
+    int i = (int)fx;
+    int j = (int)fy;
+    float ax = fx - i;
+    float ay = fy - j;
+    const float* Row0 = H + (size_t)j * w;
+    const float* Row1 = j + 1 < h ? Row0 + w : Row0;
+    int i1 = i + 1 < w ? i + 1 : i;
+    float Top = Row0[i] + ax * (Row0[i1] - Row0[i]);
+    float Bottom = Row1[i] + ax * (Row1[i1] - Row1[i]);
+    return Top + ay * (Bottom - Top);
+}
+
+// Costs of the edges Begin, ..., End - 1. Edges are batched by four, so that the
+// samples of a batch are interpolated together, and the rest are done one by one.
+void edge_costs(const HeightMap& Relief, const std::vector<sf::Vector2f>& P, const std::vector<std::pair<int, int>>& E,
+                float HeightWeight, float SlopeWeight, int Samples, size_t Begin, size_t End, float* Out)
+{
+    const float* H = Relief.RawData();
+    int w = Relief.GetWidth();
+    int h = Relief.GetHeight();
+    float Step = 1.0f / (Samples - 1);
+    float MeanWeight = HeightWeight / Samples;
+    float MaxX = (float)(w - 1);
+    float MaxY = (float)(h - 1);
+
+    // The center of pixel i is at (i + 0.5) / w in the unit square
+    size_t e = Begin;
+#ifdef RT_EDGE_COSTS_SSE2
+    __m128 Zero = _mm_setzero_ps();
+    __m128 One = _mm_set1_ps(1.0f);
+    __m128 VMaxX = _mm_set1_ps(MaxX);
+    __m128 VMaxY = _mm_set1_ps(MaxY);
+    __m128 VMean = _mm_set1_ps(MeanWeight);
+    __m128 VSlope = _mm_set1_ps(SlopeWeight);
+    __m128 AbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    for (; e + 4 <= End; e += 4)
+    {
+        alignas(16) float X0[4], Y0[4], DX[4], DY[4], L[4];
+        for (int l = 0; l < 4; ++l)
+        {
+            sf::Vector2f p = P[E[e + l].first];
+            sf::Vector2f q = P[E[e + l].second];
+            X0[l] = p.x * w - 0.5f;
+            Y0[l] = p.y * h - 0.5f;
+            DX[l] = (q.x - p.x) * w;
+            DY[l] = (q.y - p.y) * h;
+            L[l] = (q - p).length();
+        }
+        __m128 VX0 = _mm_load_ps(X0);
+        __m128 VY0 = _mm_load_ps(Y0);
+        __m128 VDX = _mm_load_ps(DX);
+        __m128 VDY = _mm_load_ps(DY);
+
+        __m128 Sum = Zero;
+        __m128 Climb = Zero;
+        __m128 Prev = Zero;
+        for (int k = 0; k < Samples; ++k)
+        {
+            __m128 T = _mm_set1_ps(k * Step);
+            __m128 FX = _mm_min_ps(_mm_max_ps(_mm_add_ps(VX0, _mm_mul_ps(T, VDX)), Zero), VMaxX);
+            __m128 FY = _mm_min_ps(_mm_max_ps(_mm_add_ps(VY0, _mm_mul_ps(T, VDY)), Zero), VMaxY);
+            __m128i IX = _mm_cvttps_epi32(FX);
+            __m128i IY = _mm_cvttps_epi32(FY);
+            __m128 AX = _mm_sub_ps(FX, _mm_cvtepi32_ps(IX));
+            __m128 AY = _mm_sub_ps(FY, _mm_cvtepi32_ps(IY));
+
+            // SSE2 has no gather, so only the four taps are loaded one by one
+            alignas(16) int I[4], J[4];
+            alignas(16) float H00[4], H10[4], H01[4], H11[4];
+            _mm_store_si128((__m128i*)I, IX);
+            _mm_store_si128((__m128i*)J, IY);
+            for (int l = 0; l < 4; ++l)
+            {
+                const float* Row0 = H + (size_t)J[l] * w;
+                const float* Row1 = J[l] + 1 < h ? Row0 + w : Row0;
+                int i1 = I[l] + 1 < w ? I[l] + 1 : I[l];
+                H00[l] = Row0[I[l]];
+                H10[l] = Row0[i1];
+                H01[l] = Row1[I[l]];
+                H11[l] = Row1[i1];
+            }
+            __m128 V00 = _mm_load_ps(H00);
+            __m128 V01 = _mm_load_ps(H01);
+            __m128 Top = _mm_add_ps(V00, _mm_mul_ps(AX, _mm_sub_ps(_mm_load_ps(H10), V00)));
+            __m128 Bottom = _mm_add_ps(V01, _mm_mul_ps(AX, _mm_sub_ps(_mm_load_ps(H11), V01)));
+            __m128 V = _mm_add_ps(Top, _mm_mul_ps(AY, _mm_sub_ps(Bottom, Top)));
+
+            if (k == 0)
+                Prev = V;
+            Sum = _mm_add_ps(Sum, V);
+            Climb = _mm_add_ps(Climb, _mm_and_ps(_mm_sub_ps(V, Prev), AbsMask));
+            Prev = V;
+        }
+        __m128 Cost = _mm_mul_ps(_mm_load_ps(L), _mm_add_ps(One, _mm_mul_ps(VMean, Sum)));
+        _mm_storeu_ps(Out + e, _mm_add_ps(Cost, _mm_mul_ps(VSlope, Climb)));
+    }
+#endif
+    for (; e < End; ++e)
+    {
+        sf::Vector2f p = P[E[e].first];
+        sf::Vector2f q = P[E[e].second];
+        float x0 = p.x * w - 0.5f;
+        float y0 = p.y * h - 0.5f;
+        float dx = (q.x - p.x) * w;
+        float dy = (q.y - p.y) * h;
+        float Sum = 0.0f;
+        float Climb = 0.0f;
+        float Prev = 0.0f;
+        for (int k = 0; k < Samples; ++k)
+        {
+            float t = k * Step;
+            float fx = std::min(std::max(x0 + t * dx, 0.0f), MaxX);
+            float fy = std::min(std::max(y0 + t * dy, 0.0f), MaxY);
+            float v = sample_height(H, w, h, fx, fy);
+            if (k == 0)
+                Prev = v;
+            Sum += v;
+            Climb += std::abs(v - Prev);
+            Prev = v;
+        }
+        Out[e] = (q - p).length() * (1.0f + MeanWeight * Sum) + SlopeWeight * Climb;
+    }
+}
+
+} // namespace
+
+
+std::vector<float> terrain_edge_costs(const HeightMap& Relief, const std::vector<sf::Vector2f>& P,
+                                      const std::vector<std::pair<int, int>>& E, float HeightWeight, float SlopeWeight,
+                                      int Samples, ThreadPool* Pool)
+{
+    RT_PROFILE_SCOPE("edge_costs");
+    if (Samples < 2)
+    {
+        std::stringstream ss;
+        ss << "Edges must be sampled at least at their two ends, not at " << Samples << " points.";
+        throw std::runtime_error(ss.str());
+    }
+
+    size_t Count = E.size();
+    std::vector<float> Costs(Count);
+    // Chunks are multiples of four edges, so that only the last one has a scalar tail
+    parallel_for(Pool, Count, 1 << 14, [&](size_t Begin, size_t End)
+    {
+        edge_costs(Relief, P, E, HeightWeight, SlopeWeight, Samples, Begin, End, Costs.data());
+    }, 4);
+
+    RT_PROFILE_COUNT("edge_costs.edges", (int64_t)Count);
+    return Costs;
+}
\ No newline at end of file
@@ -10,8 +10,32 @@
  * @date        2023-08-24
  */
 #include <geometry.hpp>
+#include <profiler.hpp>
 #include <cmath>
 #include <iostream>
+#include <algorithm>
+
+
+namespace
+{
+
+// Normalized gaussian kernel of 2 ks + 1 taps
+void gauss_kernel(float* ker, int ks, float sigma)
+{
+    ker[ks] = 1.0f;
+    float sum = 1.0f;
+    for (int i = 0; i < ks; ++i)
+    {
+        float x = i;
+        ker[ks - i - 1] = std::exp(-x * x / (2 * sigma * sigma));
+        ker[ks + i + 1] = ker[ks - i - 1];
+        sum += ker[ks + i + 1] * 2;
+    }
+    for (int i = 0; i < 2 * ks + 1; ++i)
+        ker[i] /= sum;
+}
+
+} // namespace
 
 
 void gauss_blur(sf::Image& Img, int ksx, int ksy, float sigma)
@@ -115,11 +139,23 @@ void gauss_blur(sf::Image& Img, int ksx, int ksy, float sigma)
 }
 
 
-void gauss_blur(HeightMap& HM, int ksx, int ksy, float sigma)
+// The banded blur keeps 2 ksy + 1 rows of the horizontal pass, plus the row
+// being accumulated and both kernels
+size_t gauss_blur_scratch_size(int w, int h, int ksx, int ksy)
 {
-    int ksmax = std::max(ksx, ksy);
+    size_t Full = 2 * std::max(ksx, ksy) + 1 + std::max(w, h);
+    size_t Band = (size_t)(2 * ksy + 2) * w + 2 * ksx + 1 + 2 * ksy + 1;
+    return std::max(Full, Band);
+}
+
+void gauss_blur(HeightMap& HM, int ksx, int ksy, float sigma, float* Scratch)
+{
+    RT_PROFILE_SCOPE("gauss_blur");
+    RT_PROFILE_COUNT("gauss_blur.pixels", 2 * (int64_t)HM.GetWidth() * HM.GetHeight());
     int smax = std::max(HM.GetWidth(), HM.GetHeight());
-    float* tmp = (float*)malloc((2 * ksmax + 1 + smax) * sizeof(float));
+    float* tmp = Scratch;
+    if (tmp == nullptr)
+        tmp = (float*)malloc(gauss_blur_scratch_size(HM.GetWidth(), HM.GetHeight(), ksx, ksy) * sizeof(float));
     if (tmp == nullptr)
         throw std::runtime_error("Cannot allocate support memory for gaussian blur.");
 
@@ -127,17 +163,7 @@ void gauss_blur(HeightMap& HM, int ksx, int ksy, float sigma)
 
 
     // Horizontal blur
-    ker[ksx] = 1.0f;
-    float sum = 1.0f;
-    for (int i = 0; i < ksx; ++i)
-    {
-        float x = i;
-        ker[ksx - i - 1] = std::exp(-x * x / (2 * sigma * sigma));
-        ker[ksx + i + 1] = ker[ksx - i - 1];
-        sum += ker[ksx + i + 1] * 2;
-    }
-    for (int i = 0; i < 2 * ksx + 1; ++i)
-        ker[i] /= sum;
+    gauss_kernel(ker, ksx, sigma);
     
     // Blur each line
     for (int j = 0; j < HM.GetHeight(); ++j)
@@ -164,17 +190,7 @@ void gauss_blur(HeightMap& HM, int ksx, int ksy, float sigma)
 
 
     // Vertical blur
-    ker[ksy] = 1.0f;
-    sum = 1.0f;
-    for (int i = 0; i < ksy; ++i)
-    {
-        float y = i;
-        ker[ksy - i - 1] = std::exp(-y * y / (2 * sigma * sigma));
-        ker[ksy + i + 1] = ker[ksy - i - 1];
-        sum += ker[ksy + i + 1] * 2;
-    }
-    for (int i = 0; i < 2 * ksy + 1; ++i)
-        ker[i] /= sum;
+    gauss_kernel(ker, ksy, sigma);
 
     // Blur each column
     for (int i = 0; i < HM.GetWidth(); ++i)
@@ -192,7 +208,7 @@ void gauss_blur(HeightMap& HM, int ksx, int ksy, float sigma)
                 if (jj >= 0)
                     pixel += ker[ksy - dy - 1] * tmp[jj];
                 jj = j + dy + 1;
-                if (jj < HM.GetWidth())
+                if (jj < HM.GetHeight())
                     pixel += ker[ksy + dy + 1] * tmp[jj];
             }
             HM.Set(i, j, pixel);
@@ -200,5 +216,113 @@ void gauss_blur(HeightMap& HM, int ksx, int ksy, float sigma)
     }
 
 
-    free(tmp);
+    if (Scratch == nullptr)
+        free(tmp);
+}
+
+
+// Rows of the horizontal pass are kept in a ring of 2 ksy + 1 rows, each zero
+// outside the spans of its row, and the vertical pass accumulates whole spans
+// of a row at once. Every pixel sums its taps in the same order as above.
+void gauss_blur(HeightMap& HM, const RowSpans& Band, int ksx, int ksy, float sigma, float* Scratch)
+{
+    RT_PROFILE_SCOPE("gauss_blur_band");
+    int w = HM.GetWidth();
+    int h = HM.GetHeight();
+    int64_t Area = 0;
+    for (const auto& Span : Band.Spans)
+        Area += Span.second - Span.first;
+    RT_PROFILE_COUNT("gauss_blur.pixels", 2 * Area);
+    float* tmp = Scratch;
+    if (tmp == nullptr)
+        tmp = (float*)malloc(gauss_blur_scratch_size(w, h, ksx, ksy) * sizeof(float));
+    if (tmp == nullptr)
+        throw std::runtime_error("Cannot allocate support memory for gaussian blur.");
+
+    int nRing = 2 * ksy + 1;
+    float* Ring = tmp;
+    float* Acc = Ring + (size_t)nRing * w;
+    float* kerx = Acc + w;
+    float* kery = kerx + 2 * ksx + 1;
+    gauss_kernel(kerx, ksx, sigma);
+    gauss_kernel(kery, ksy, sigma);
+    std::fill(Ring, Ring + (size_t)nRing * w, 0.0f);
+
+    float* Data = HM.RawData();
+    float Min = 0.0f;
+    float Max = 0.0f;
+
+    // Horizontal blur of row r into its slot of the ring
+    auto Horizontal = [&](int r)
+    {
+        float* Dst = Ring + (size_t)(r % nRing) * w;
+        if (r >= nRing)
+        {
+            for (int s = Band.Rows[r - nRing]; s < Band.Rows[r - nRing + 1]; ++s)
+                std::fill(Dst + Band.Spans[s].first, Dst + Band.Spans[s].second, 0.0f);
+        }
+        const float* Src = Data + (size_t)r * w;
+        for (int s = Band.Rows[r]; s < Band.Rows[r + 1]; ++s)
+        {
+            for (int i = Band.Spans[s].first; i < Band.Spans[s].second; ++i)
+            {
+                float pixel = kerx[ksx] * Src[i];
+                for (int dx = 0; dx < ksx; ++dx)
+                {
+                    int ii = i - dx - 1;
+                    if (ii >= 0)
+                        pixel += kerx[ksx - dx - 1] * Src[ii];
+                    ii = i + dx + 1;
+                    if (ii < w)
+                        pixel += kerx[ksx + dx + 1] * Src[ii];
+                }
+                Dst[i] = pixel;
+                Min = std::min(Min, pixel);
+                Max = std::max(Max, pixel);
+            }
+        }
+    };
+
+    // Row j is written once the rows up to j + ksy are in the ring
+    for (int r = 0; r < std::min(ksy, h); ++r)
+        Horizontal(r);
+    for (int j = 0; j < h; ++j)
+    {
+        if (j + ksy < h)
+            Horizontal(j + ksy);
+        const float* Mid = Ring + (size_t)(j % nRing) * w;
+        float* Out = Data + (size_t)j * w;
+        for (int s = Band.Rows[j]; s < Band.Rows[j + 1]; ++s)
+        {
+            int Begin = Band.Spans[s].first;
+            int End = Band.Spans[s].second;
+            for (int i = Begin; i < End; ++i)
+                Acc[i] = kery[ksy] * Mid[i];
+            for (int dy = 0; dy < ksy; ++dy)
+            {
+                if (j - dy - 1 >= 0)
+                {
+                    const float* Row = Ring + (size_t)((j - dy - 1) % nRing) * w;
+                    for (int i = Begin; i < End; ++i)
+                        Acc[i] += kery[ksy - dy - 1] * Row[i];
+                }
+                if (j + dy + 1 < h)
+                {
+                    const float* Row = Ring + (size_t)((j + dy + 1) % nRing) * w;
+                    for (int i = Begin; i < End; ++i)
+                        Acc[i] += kery[ksy + dy + 1] * Row[i];
+                }
+            }
+            for (int i = Begin; i < End; ++i)
+            {
+                Out[i] = Acc[i];
+                Min = std::min(Min, Acc[i]);
+                Max = std::max(Max, Acc[i]);
+            }
+        }
+    }
+    HM.SetRange(std::min(HM.GetMin(), Min), std::max(HM.GetMax(), Max));
+
+    if (Scratch == nullptr)
+        free(tmp);
 }
\ No newline at end of file
@@ -10,85 +10,195 @@
  * @date        2023-08-24
  */
 #include <graph.hpp>
+#include <profiler.hpp>
 #include <queue>
 #include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
 
 typedef std::pair<int, int> Edge;  // unweighted unordered edges
 
-Graph::Graph(const std::vector<sf::Vector2f>& V, const std::vector<std::pair<int, int>>& E)
+
+namespace
 {
-    int nVerts = V.size();
 
-    std::set<Edge> Edges;
-    int nEdges = E.size();
-    for (int i = 0; i < nEdges; ++i)
-    {
-        Edges.emplace(std::min(E[i].first, E[i].second), std::max(E[i].first, E[i].second));
-        Edges.emplace(std::max(E[i].first, E[i].second), std::min(E[i].first, E[i].second));
-    }
+// Spreads the 16 low bits of x over the even bits
+uint32_t part_1by1(uint32_t x)
+{
+    x &= 0x0000FFFF;
+    x = (x | (x << 8)) & 0x00FF00FF;
+    x = (x | (x << 4)) & 0x0F0F0F0F;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    return x;
+}
+
+uint32_t morton_key(uint32_t x, uint32_t y)
+{
+    return part_1by1(x) | (part_1by1(y) << 1);
+}
 
-    m_Idxs.resize(nVerts + 1);
-    m_Adjs.reserve(Edges.size());
-    int CurNode = 0;
-    sf::Vector2f CurVert = V[0];
-    for (auto it = Edges.begin(); it != Edges.end(); it++)
+uint32_t hilbert_key(uint32_t x, uint32_t y)
+{
+    const uint32_t n = 1 << 16;
+    uint32_t d = 0;
+    for (uint32_t s = n / 2; s > 0; s /= 2)
     {
-        if (it->first != CurNode)
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        d += s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant, so that the curve enters it from the right corner
+        if (ry == 0)
         {
-            CurNode++;
-            m_Idxs[CurNode] = m_Adjs.size();
-            CurVert = V[CurNode];
+            if (rx == 1)
+            {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
         }
+    }
+    return d;
+}
+
+// Index in V of the vertices sorted along the curve, empty for the input order
+std::vector<int> curve_order(const std::vector<sf::Vector2f>& V, VertexOrder Order)
+{
+    std::vector<int> Sorted;
+    if (Order == VertexOrder::Input || V.empty())
+        return Sorted;
+
+    // Positions are quantized to 16 bits over their bounding box
+    sf::Vector2f Min = V[0];
+    sf::Vector2f Max = V[0];
+    for (const auto& p : V)
+    {
+        Min.x = std::min(Min.x, p.x);
+        Min.y = std::min(Min.y, p.y);
+        Max.x = std::max(Max.x, p.x);
+        Max.y = std::max(Max.y, p.y);
+    }
+    float sx = Max.x > Min.x ? 65535.0f / (Max.x - Min.x) : 0.0f;
+    float sy = Max.y > Min.y ? 65535.0f / (Max.y - Min.y) : 0.0f;
+
+    std::vector<std::pair<uint32_t, int>> Keys(V.size());
+    for (size_t i = 0; i < V.size(); ++i)
+    {
+        uint32_t x = (uint32_t)((V[i].x - Min.x) * sx);
+        uint32_t y = (uint32_t)((V[i].y - Min.y) * sy);
+        Keys[i].first = Order == VertexOrder::Morton ? morton_key(x, y) : hilbert_key(x, y);
+        Keys[i].second = (int)i;
+    }
+    std::sort(Keys.begin(), Keys.end());
+
+    Sorted.resize(V.size());
+    for (size_t i = 0; i < V.size(); ++i)
+        Sorted[i] = Keys[i].second;
+    return Sorted;
+}
+
+} // namespace
+
+
+Graph::Graph(const std::vector<sf::Vector2f>& V, const std::vector<std::pair<int, int>>& E, VertexOrder Order)
+{
+    Build(V, E, nullptr, Order);
+}
+
+Graph::Graph(const std::vector<sf::Vector2f>& V, const std::set<std::pair<int, int>>& E, VertexOrder Order)
+{
+    Build(V, std::vector<Edge>(E.begin(), E.end()), nullptr, Order);
+}
 
-        int ONode = it->second;
-        sf::Vector2f OVert = V[ONode];
-        m_Adjs.push_back({ ONode, (CurVert - OVert).length() });
+Graph::Graph(const std::vector<sf::Vector2f>& V, const std::vector<std::pair<int, int>>& E,
+             const std::vector<float>& Weights, VertexOrder Order)
+{
+    if (Weights.size() != E.size())
+    {
+        std::stringstream ss;
+        ss << "The graph has " << E.size() << " edges, but " << Weights.size() << " weights.";
+        throw std::runtime_error(ss.str());
     }
-    m_Idxs[CurNode + 1] = m_Adjs.size();
+    Build(V, E, Weights.data(), Order);
 }
 
-Graph::Graph(const std::vector<sf::Vector2f>& V, const std::set<std::pair<int, int>>& E)
+void Graph::Build(const std::vector<sf::Vector2f>& V, const std::vector<std::pair<int, int>>& E,
+                  const float* Weights, VertexOrder Order)
 {
+    RT_PROFILE_SCOPE("graph");
     int nVerts = V.size();
 
-    std::set<Edge> Edges;
-    int nEdges = E.size();
-    for (auto it = E.begin(); it != E.end(); it++)
+    m_Order = curve_order(V, Order);
+    m_Rank.clear();
+    if (!m_Order.empty())
+    {
+        m_Rank.resize(nVerts);
+        for (int v = 0; v < nVerts; ++v)
+            m_Rank[m_Order[v]] = v;
+    }
+
+    // Bucket both directions of every edge by their source
+    m_Idxs.assign(nVerts + 1, 0);
+    for (const auto& e : E)
+    {
+        m_Idxs[Vertex(e.first) + 1]++;
+        m_Idxs[Vertex(e.second) + 1]++;
+    }
+    for (int v = 0; v < nVerts; ++v)
+        m_Idxs[v + 1] += m_Idxs[v];
+    std::vector<std::pair<int, float>> Adj(m_Idxs[nVerts]);
+    std::vector<int> Fill(m_Idxs.begin(), m_Idxs.end() - 1);
+    for (size_t i = 0; i < E.size(); ++i)
     {
-        Edges.emplace(std::min(it->first, it->second), std::max(it->first, it->second));
-        Edges.emplace(std::max(it->first, it->second), std::min(it->first, it->second));
+        const auto& e = E[i];
+        float w = Weights != nullptr ? Weights[i] : (V[e.first] - V[e.second]).length();
+        int a = Vertex(e.first);
+        int b = Vertex(e.second);
+        Adj[Fill[a]++] = { b, w };
+        Adj[Fill[b]++] = { a, w };
     }
 
-    m_Idxs.resize(nVerts + 1);
-    m_Adjs.reserve(Edges.size());
-    int CurNode = 0;
-    sf::Vector2f CurVert = V[0];
-    for (auto it = Edges.begin(); it != Edges.end(); it++)
+    // Sort every adjacency list and drop the repeated edges, keeping the lightest
+    m_Dests.resize(Adj.size());
+    m_Weights.resize(Adj.size());
+    int Size = 0;
+    for (int v = 0; v < nVerts; ++v)
     {
-        if (it->first != CurNode)
+        int Begin = m_Idxs[v];
+        int End = m_Idxs[v + 1];
+        std::sort(Adj.begin() + Begin, Adj.begin() + End);
+        m_Idxs[v] = Size;
+        for (int k = Begin; k < End; ++k)
         {
-            CurNode++;
-            m_Idxs[CurNode] = m_Adjs.size();
-            CurVert = V[CurNode];
+            if (k > Begin && Adj[k].first == Adj[k - 1].first)
+                continue;
+            m_Dests[Size] = Adj[k].first;
+            m_Weights[Size++] = Adj[k].second;
         }
-
-        int ONode = it->second;
-        sf::Vector2f OVert = V[ONode];
-        m_Adjs.push_back({ ONode, (CurVert - OVert).length() });
     }
-    m_Idxs[CurNode + 1] = m_Adjs.size();
+    m_Idxs[nVerts] = Size;
+    m_Dests.resize(Size);
+    m_Weights.resize(Size);
 }
 
 Graph::Graph(const Graph& G)
 {
     m_Idxs = G.m_Idxs;
-    m_Adjs = G.m_Adjs;
+    m_Dests = G.m_Dests;
+    m_Weights = G.m_Weights;
+    m_Order = G.m_Order;
+    m_Rank = G.m_Rank;
 }
 
 Graph& Graph::operator=(const Graph& G)
 {
     m_Idxs = G.m_Idxs;
-    m_Adjs = G.m_Adjs;
+    m_Dests = G.m_Dests;
+    m_Weights = G.m_Weights;
+    m_Order = G.m_Order;
+    m_Rank = G.m_Rank;
 
     return *this;
 }
@@ -96,78 +206,133 @@ Graph& Graph::operator=(const Graph& G)
 Graph::Graph(Graph&& G)
 {
     m_Idxs = std::move(G.m_Idxs);
-    m_Adjs = std::move(G.m_Adjs);
+    m_Dests = std::move(G.m_Dests);
+    m_Weights = std::move(G.m_Weights);
+    m_Order = std::move(G.m_Order);
+    m_Rank = std::move(G.m_Rank);
 }
 
 Graph& Graph::operator=(Graph&& G)
 {
     m_Idxs = std::move(G.m_Idxs);
-    m_Adjs = std::move(G.m_Adjs);
+    m_Dests = std::move(G.m_Dests);
+    m_Weights = std::move(G.m_Weights);
+    m_Order = std::move(G.m_Order);
+    m_Rank = std::move(G.m_Rank);
 
     return *this;
 }
 
 Graph::~Graph() { }
 
-int Graph::NumVertices() const { return m_Idxs.size(); }
-int Graph::NumEdges() const { return m_Adjs.size() / 2; }
-int Graph::NumAdjacents(int i) const { return m_Idxs[i + 1] - m_Idxs[i]; }
+int Graph::NumVertices() const { return m_Idxs.size() - 1; }
+int Graph::NumEdges() const { return m_Dests.size() / 2; }
+int Graph::NumAdjacents(int i) const { return m_Idxs[Vertex(i) + 1] - m_Idxs[Vertex(i)]; }
 
-const WEdge& Graph::GetAdjacent(int node_i, int adj_i) const
+WEdge Graph::GetAdjacent(int node_i, int adj_i) const
 {
-    return m_Adjs[m_Idxs[node_i] + adj_i];
+    int k = m_Idxs[Vertex(node_i)] + adj_i;
+    return { Original(m_Dests[k]), m_Weights[k] };
 }
 
-Path Graph::ShortestPath(int src, int trg) const
+const std::vector<int>& Graph::GetOrder() const { return m_Order; }
+
+// Search from the stored vertex s, stopping at t (never, if t is -1)
+void Graph::Dijkstra(int s, int t, std::vector<float>& Dist, std::vector<int>& Pred) const
 {
+    int64_t Pushes = 1;
+    int64_t Pops = 0;
     int nVerts = NumVertices();
-    std::vector<float> Dist;
-    Dist.resize(nVerts, std::numeric_limits<float>::infinity());
-    std::vector<int> Pred;
-    Pred.resize(nVerts, -1);
+    Dist.assign(nVerts, std::numeric_limits<float>::infinity());
+    Pred.assign(nVerts, -1);
 
     std::priority_queue<std::pair<float, int>,
                         std::vector<std::pair<float, int>>,
                         std::greater<std::pair<float, int>>> Q;
 
-    Dist[src] = 0;
-    Q.emplace(0.0f, src);
+    Dist[s] = 0;
+    Q.emplace(0.0f, s);
     while (!Q.empty())
     {
         auto p = Q.top();
         Q.pop();
+        Pops++;
 
         int n = p.second;
-        if (n == trg)
+        if (n == t)
             break;
         float w = p.first;
-        int deg = NumAdjacents(n);
-        for (int i = 0; i < deg; ++i)
+        for (int k = m_Idxs[n]; k < m_Idxs[n + 1]; ++k)
         {
-            auto a = GetAdjacent(n, i);
-            int m = a.Destination;
-            float d = a.Weight + w;
+            int m = m_Dests[k];
+            float d = m_Weights[k] + w;
             if (d < Dist[m])
             {
                 Dist[m] = d;
                 Pred[m] = n;
 
                 Q.emplace(d, m);
+                Pushes++;
             }
         }
     }
+    RT_PROFILE_COUNT("dijkstra.pushes", Pushes);
+    RT_PROFILE_COUNT("dijkstra.pops", Pops);
+}
 
+Path Graph::ShortestPath(int src, int trg) const
+{
+    RT_PROFILE_SCOPE("shortest_path");
+    // The search runs on the stored vertices, and only the path is mapped back
+    int t = Vertex(trg);
+    std::vector<float> Dist;
+    std::vector<int> Pred;
+    Dijkstra(Vertex(src), t, Dist, Pred);
 
     Path P;
-    P.Nodes.reserve(nVerts);
-    P.Length = Dist[trg];
-    int tmp = trg;
+    P.Nodes.reserve(NumVertices());
+    P.Length = Dist[t];
+    int tmp = t;
     while (tmp != -1)
     {
-        P.Nodes.push_back(tmp);
+        P.Nodes.push_back(Original(tmp));
         tmp = Pred[tmp];
     }
     std::reverse(P.Nodes.begin(), P.Nodes.end());
 
     return P;
+}
+
+PathTree Graph::ShortestPathTree(int root) const
+{
+    RT_PROFILE_SCOPE("shortest_path_tree");
+    std::vector<float> Dist;
+    std::vector<int> Pred;
+    Dijkstra(Vertex(root), -1, Dist, Pred);
+
+    // Paths are symmetric, so the predecessors from the root lead back to it
+    int nVerts = NumVertices();
+    PathTree T;
+    T.Root = root;
+    T.Next.resize(nVerts);
+    T.Dist.resize(nVerts);
+    for (int v = 0; v < nVerts; ++v)
+    {
+        int o = Original(v);
+        T.Next[o] = Pred[v] < 0 ? -1 : Original(Pred[v]);
+        T.Dist[o] = Dist[v];
+    }
+    return T;
+}
+
+
+Path PathTree::PathToRoot(int v) const
+{
+    Path P;
+    P.Length = Dist[v];
+    if (v != Root && Next[v] < 0)
+        return P;
+    for (int n = v; n != -1; n = Next[n])
+        P.Nodes.push_back(n);
+    return P;
 }
\ No newline at end of file
@@ -14,40 +14,83 @@
 #include <cstring>
 #include <cmath>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace
+{
+
+/**
+ * Header of a memory-mapped heightmap file. The float grid follows it, so the
+ * header size keeps the grid aligned for vector loads.
+ */
+struct MappedHeader
+{
+    char Magic[4];          // "RTHM"
+    uint32_t Version;
+    int32_t Width;
+    int32_t Height;
+    float Min;
+    float Max;
+    char Reserved[40];
+};
+static_assert(sizeof(MappedHeader) == 64, "Mapped heightmap header must be 64 bytes.");
 
+const char MappedMagic[4] = { 'R', 'T', 'H', 'M' };
+const uint32_t MappedVersion = 1;
 
-HeightMap::HeightMap(int Size)
+} // namespace
+
+
+HeightMap::HeightMap()
 {
-    m_Width = Size;
-    m_Height = Size;
+    m_Width = 0;
+    m_Height = 0;
     m_QDirty = false;
     m_Min = 0.0f;
     m_Max = 0.0f;
-    m_Data = (float*)std::calloc(m_Width * m_Height, sizeof(float));
-    m_QData = (unsigned char*)std::calloc(m_Width * m_Height, sizeof(unsigned char));
+    m_Data = nullptr;
+    m_QData = nullptr;
+    m_MapBase = nullptr;
+    m_MapSize = 0;
+    m_MapShared = false;
+    m_MapHandle = nullptr;
+    m_Borrowed = false;
 }
 
-HeightMap::HeightMap(int Width, int Height)
+HeightMap::HeightMap(int Size) : HeightMap(Size, Size) { }
+
+HeightMap::HeightMap(int Width, int Height) : HeightMap()
 {
     m_Width = Width;
     m_Height = Height;
-    m_QDirty = false;
-    m_Min = 0.0f;
-    m_Max = 0.0f;
-    m_Data = (float*)std::calloc(m_Width * m_Height, sizeof(float));
-    m_QData = (unsigned char*)std::calloc(m_Width * m_Height, sizeof(unsigned char));
+    m_Data = (float*)std::calloc((size_t)m_Width * m_Height, sizeof(float));
+    if (m_Data == nullptr)
+        throw std::runtime_error("Cannot allocate memory for the heightmap.");
 }
 
-HeightMap::HeightMap(const sf::Image& Img)
+HeightMap::HeightMap(int Width, int Height, float* Data) : HeightMap()
 {
-    m_Width = Img.getSize().x;
-    m_Height = Img.getSize().y;
-    m_QDirty = false;
-    m_Min = 0.0f;
-    m_Max = 0.0f;
-    m_Data = (float*)std::calloc(m_Width * m_Height, sizeof(float));
-    m_QData = (unsigned char*)std::calloc(m_Width * m_Height, sizeof(unsigned char));
+    m_Width = Width;
+    m_Height = Height;
+    m_Data = Data;
+    m_Borrowed = true;
+}
 
+HeightMap::HeightMap(const sf::Image& Img) : HeightMap(Img.getSize().x, Img.getSize().y)
+{
     for (int j = 0; j < m_Height; ++j)
     {
         for (int i = 0; i < m_Width; ++i)
@@ -55,53 +98,47 @@ HeightMap::HeightMap(const sf::Image& Img)
             Set(i, j, Img.getPixel({ i, j }).r / 255.0f);
         }
     }
-
-    Quantize();
 }
 
-HeightMap::HeightMap(const HeightMap& HM)
+HeightMap::HeightMap(const HeightMap& HM) : HeightMap()
 {
-    m_Width = HM.m_Width;
-    m_Height = HM.m_Height;
-    m_QDirty = HM.m_QDirty;
-    m_Min = HM.m_Min;
-    m_Max = HM.m_Max;
-    m_Data = (float*)std::malloc(m_Width * m_Height * sizeof(float));
-    m_Data = (float*)std::memcpy(m_Data, HM.m_Data, m_Width * m_Height * sizeof(float));
-    m_QData = (unsigned char*)std::malloc(m_Width * m_Height * sizeof(unsigned char));
-    m_QData = (unsigned char*)std::memcpy(m_QData, HM.m_QData, m_Width * m_Height * sizeof(unsigned char));
+    *this = HM;
 }
 
 HeightMap& HeightMap::operator=(const HeightMap& HM)
 {
+    if (this == &HM)
+        return *this;
+    Release();
+
+    size_t numel = (size_t)HM.m_Width * HM.m_Height;
     m_Width = HM.m_Width;
     m_Height = HM.m_Height;
     m_QDirty = HM.m_QDirty;
     m_Min = HM.m_Min;
     m_Max = HM.m_Max;
-    m_Data = (float*)std::malloc(m_Width * m_Height * sizeof(float));
-    m_Data = (float*)std::memcpy(m_Data, HM.m_Data, m_Width * m_Height * sizeof(float));
-    m_QData = (unsigned char*)std::malloc(m_Width * m_Height * sizeof(unsigned char));
-    m_QData = (unsigned char*)std::memcpy(m_QData, HM.m_QData, m_Width * m_Height * sizeof(unsigned char));
+    m_Data = (float*)std::malloc(numel * sizeof(float));
+    m_Data = (float*)std::memcpy(m_Data, HM.m_Data, numel * sizeof(float));
+    if (HM.m_QData != nullptr)
+    {
+        m_QData = (unsigned char*)std::malloc(numel * sizeof(unsigned char));
+        m_QData = (unsigned char*)std::memcpy(m_QData, HM.m_QData, numel * sizeof(unsigned char));
+    }
 
     return *this;
 }
 
-HeightMap::HeightMap(HeightMap&& HM)
+HeightMap::HeightMap(HeightMap&& HM) : HeightMap()
 {
-    m_Width = HM.m_Width;
-    m_Height = HM.m_Height;
-    m_QDirty = HM.m_QDirty;
-    m_Min = HM.m_Min;
-    m_Max = HM.m_Max;
-    m_Data = HM.m_Data;
-    HM.m_Data = nullptr;
-    m_QData = HM.m_QData;
-    HM.m_QData = nullptr;
+    *this = std::move(HM);
 }
 
 HeightMap& HeightMap::operator=(HeightMap&& HM)
 {
+    if (this == &HM)
+        return *this;
+    Release();
+
     m_Width = HM.m_Width;
     m_Height = HM.m_Height;
     m_QDirty = HM.m_QDirty;
@@ -111,16 +148,177 @@ HeightMap& HeightMap::operator=(HeightMap&& HM)
     HM.m_Data = nullptr;
     m_QData = HM.m_QData;
     HM.m_QData = nullptr;
+    m_MapBase = HM.m_MapBase;
+    HM.m_MapBase = nullptr;
+    m_MapSize = HM.m_MapSize;
+    m_MapShared = HM.m_MapShared;
+    m_MapHandle = HM.m_MapHandle;
+    HM.m_MapHandle = nullptr;
+    m_Borrowed = HM.m_Borrowed;
+    HM.m_Borrowed = false;
 
     return *this;
 }
 
 HeightMap::~HeightMap()
 {
-    if (m_Data != nullptr)
+    Release();
+}
+
+void HeightMap::Release()
+{
+    if (m_MapBase != nullptr)
+    {
+        if (m_MapShared)
+        {
+            MappedHeader* Header = (MappedHeader*)m_MapBase;
+            Header->Min = m_Min;
+            Header->Max = m_Max;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(m_MapBase);
+        CloseHandle((HANDLE)m_MapHandle);
+#else
+        munmap(m_MapBase, m_MapSize);
+#endif
+        m_MapBase = nullptr;
+        m_MapHandle = nullptr;
+        m_Data = nullptr;
+    }
+    if (m_Data != nullptr && !m_Borrowed)
         free(m_Data);
     if (m_QData != nullptr)
         free(m_QData);
+    m_Data = nullptr;
+    m_QData = nullptr;
+    m_Borrowed = false;
+}
+
+
+void HeightMap::MapFile(const std::string& Filename, size_t Size, bool Create, bool Shared)
+{
+    std::stringstream ss;
+    ss << "Cannot map file " << Filename << " in memory.";
+
+#ifdef _WIN32
+    HANDLE File = CreateFileA(Filename.c_str(),
+                              GENERIC_READ | (Shared ? GENERIC_WRITE : 0),
+                              FILE_SHARE_READ, NULL,
+                              Create ? CREATE_ALWAYS : OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (File == INVALID_HANDLE_VALUE)
+        throw std::runtime_error(ss.str());
+    HANDLE Mapping = CreateFileMappingA(File, NULL, Shared ? PAGE_READWRITE : PAGE_WRITECOPY,
+                                        (DWORD)((uint64_t)Size >> 32), (DWORD)Size, NULL);
+    CloseHandle(File);
+    if (Mapping == NULL)
+        throw std::runtime_error(ss.str());
+    void* Base = MapViewOfFile(Mapping, Shared ? FILE_MAP_WRITE : FILE_MAP_COPY, 0, 0, Size);
+    if (Base == NULL)
+    {
+        CloseHandle(Mapping);
+        throw std::runtime_error(ss.str());
+    }
+    m_MapHandle = Mapping;
+#else
+    int Flags = Create ? (O_RDWR | O_CREAT | O_TRUNC) : (Shared ? O_RDWR : O_RDONLY);
+    int fd = open(Filename.c_str(), Flags, 0644);
+    if (fd < 0)
+        throw std::runtime_error(ss.str());
+    if (Create && ftruncate(fd, Size) != 0)
+    {
+        close(fd);
+        throw std::runtime_error(ss.str());
+    }
+    // Private mappings of read-only files are still writable, copy-on-write
+    void* Base = mmap(nullptr, Size, PROT_READ | PROT_WRITE, Shared ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (Base == MAP_FAILED)
+        throw std::runtime_error(ss.str());
+#endif
+
+    m_MapBase = Base;
+    m_MapSize = Size;
+    m_MapShared = Shared;
+    m_Data = (float*)((char*)Base + sizeof(MappedHeader));
+}
+
+HeightMap HeightMap::CreateMapped(const std::string& Filename, int Width, int Height)
+{
+    HeightMap HM;
+    HM.m_Width = Width;
+    HM.m_Height = Height;
+    HM.MapFile(Filename, sizeof(MappedHeader) + (size_t)Width * Height * sizeof(float), true, true);
+
+    // A freshly extended file reads as zeros, like a calloc'd map
+    MappedHeader* Header = (MappedHeader*)HM.m_MapBase;
+    std::memcpy(Header->Magic, MappedMagic, 4);
+    Header->Version = MappedVersion;
+    Header->Width = Width;
+    Header->Height = Height;
+    Header->Min = 0.0f;
+    Header->Max = 0.0f;
+
+    return HM;
+}
+
+HeightMap HeightMap::OpenMapped(const std::string& Filename, bool Writable)
+{
+    std::ifstream stream;
+    stream.open(Filename, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!stream.is_open())
+    {
+        std::stringstream ss;
+        ss << "Cannot open file " << Filename << " for reading.";
+        throw std::runtime_error(ss.str());
+    }
+    size_t Size = stream.tellg();
+
+    // The header is checked before mapping, as a writable map of any other file
+    // would get its bytes overwritten with the range when released
+    MappedHeader Header;
+    bool Valid = Size >= sizeof(MappedHeader);
+    if (Valid)
+    {
+        stream.seekg(0);
+        Valid = (bool)stream.read((char*)&Header, sizeof(MappedHeader));
+    }
+    stream.close();
+    if (!Valid || std::memcmp(Header.Magic, MappedMagic, 4) != 0 || Header.Version != MappedVersion ||
+        Header.Width < 0 || Header.Height < 0 ||
+        Size < sizeof(MappedHeader) + (size_t)Header.Width * Header.Height * sizeof(float))
+    {
+        std::stringstream ss;
+        ss << "File " << Filename << " is not a valid mapped heightmap.";
+        throw std::runtime_error(ss.str());
+    }
+
+    HeightMap HM;
+    HM.MapFile(Filename, Size, false, Writable);
+    HM.m_Width = Header.Width;
+    HM.m_Height = Header.Height;
+    HM.m_Min = Header.Min;
+    HM.m_Max = Header.Max;
+    HM.m_QDirty = true;
+
+    return HM;
+}
+
+bool HeightMap::IsMapped() const { return m_MapBase != nullptr; }
+
+void HeightMap::Flush()
+{
+    if (m_MapBase == nullptr || !m_MapShared)
+        return;
+
+    MappedHeader* Header = (MappedHeader*)m_MapBase;
+    Header->Min = m_Min;
+    Header->Max = m_Max;
+#ifdef _WIN32
+    FlushViewOfFile(m_MapBase, m_MapSize);
+#else
+    msync(m_MapBase, m_MapSize, MS_SYNC);
+#endif
 }
 
 
@@ -137,7 +335,7 @@ float HeightMap::Get(int i, int j) const
     if (j < 0 || j >= m_Height)
         throw std::runtime_error("Index out of bound.");
 
-    return m_Data[j * m_Width + i];
+    return m_Data[(size_t)j * m_Width + i];
 }
 float& HeightMap::Get(int i, int j)
 {
@@ -146,7 +344,7 @@ float& HeightMap::Get(int i, int j)
     if (j < 0 || j >= m_Height)
         throw std::runtime_error("Index out of bound.");
 
-    return m_Data[j * m_Width + i];
+    return m_Data[(size_t)j * m_Width + i];
 }
 float HeightMap::operator()(int i, int j) const { return Get(i, j); }
 float& HeightMap::operator()(int i, int j) { return Get(i, j); }
@@ -158,18 +356,25 @@ void HeightMap::Set(int i, int j, float value)
     if (j < 0 || j >= m_Height)
         throw std::runtime_error("Index out of bound.");
 
-    m_Data[j * m_Width + i] = value;
+    m_Data[(size_t)j * m_Width + i] = value;
     m_Min = std::min(m_Min, value);
     m_Max = std::max(m_Max, value);
     m_QDirty = true;
 }
 
+void HeightMap::SetRange(float Min, float Max)
+{
+    m_Min = Min;
+    m_Max = Max;
+    m_QDirty = true;
+}
+
 
 void HeightMap::Clamp(float min, float max)
 {
     m_Min = min;
     m_Max = max;
-    size_t numel = m_Width * m_Height;
+    size_t numel = (size_t)m_Width * m_Height;
     for (size_t i = 0; i < numel; ++i)
         m_Data[i] = std::min(max, std::max(min, m_Data[i]));
     m_QDirty = true;
@@ -189,7 +394,7 @@ void HeightMap::Normalize(float min, float max)
 {
     float m_diff = m_Max - m_Min;
     float diff = max - min;
-    size_t numel = m_Width * m_Height;
+    size_t numel = (size_t)m_Width * m_Height;
     for (size_t i = 0; i < numel; ++i)
         m_Data[i] = ((m_Data[i] - m_Min) / m_diff) * diff + min;
     m_Min = min;
@@ -209,7 +414,7 @@ HeightMap HeightMap::Normalized(float min, float max) const
 
 void HeightMap::Invert()
 {
-    size_t numel = m_Width * m_Height;
+    size_t numel = (size_t)m_Width * m_Height;
     for (size_t i = 0; i < numel; ++i)
         m_Data[i] = m_Max - m_Data[i] + m_Min;
 }
@@ -226,11 +431,14 @@ HeightMap HeightMap::Inverted() const
 
 void HeightMap::Quantize()
 {
+    if (m_QData == nullptr)
+        m_QData = (unsigned char*)std::malloc((size_t)m_Width * m_Height * sizeof(unsigned char));
     float m_diff = m_Max - m_Min;
-    size_t numel = m_Width * m_Height;
+    size_t numel = (size_t)m_Width * m_Height;
     for (size_t i = 0; i < numel; ++i)
         m_QData[i] = ((m_Data[i] - m_Min) / m_diff) * 255;
 }
 bool HeightMap::IsDirty() const { return m_QDirty; }
 const unsigned char* const HeightMap::Quantized() const { return m_QData; }
-const float* const HeightMap::RawData() const { return m_Data; }
\ No newline at end of file
+const float* const HeightMap::RawData() const { return m_Data; }
+float* HeightMap::RawData() { return m_Data; }
\ No newline at end of file
@@ -0,0 +1,470 @@
+/**
+ * @file        hmap_io.cpp
+ *
+ * @brief       Implements high precision heightmap exporters.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <hmap_io.hpp>
+#include <deflate.hpp>
+#include <profiler.hpp>
+#include <stb_image_write.h>
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <cstdlib>
+
+
+PngFilter parse_png_filter(const std::string& name)
+{
+    if (name == "none")
+        return PngFilter::None;
+    if (name == "sub")
+        return PngFilter::Sub;
+    if (name == "up")
+        return PngFilter::Up;
+    if (name == "average")
+        return PngFilter::Average;
+    if (name == "paeth")
+        return PngFilter::Paeth;
+    if (name == "adaptive")
+        return PngFilter::Adaptive;
+
+    std::stringstream ss;
+    ss << "Unknown PNG filter \"" << name << "\".";
+    throw std::runtime_error(ss.str());
+}
+
+
+namespace
+{
+
+// Rows are encoded in bands of roughly this many bytes
+const size_t BandBytes = 1 << 20;
+
+
+std::ofstream open_output(const std::string& filename)
+{
+    std::ofstream of;
+    of.open(filename, std::ios::out | std::ios::binary);
+    if (!of.is_open())
+    {
+        std::stringstream ss;
+        ss << "Cannot open file " << filename << " for writing.";
+        throw std::runtime_error(ss.str());
+    }
+    return of;
+}
+
+void close_output(std::ofstream& of)
+{
+    RT_PROFILE_COUNT("bytes_written", (int64_t)of.tellp());
+    of.close();
+}
+
+int band_rows(size_t RowBytes)
+{
+    return (int)std::max<size_t>(1, BandBytes / std::max<size_t>(1, RowBytes));
+}
+
+void put_be32(unsigned char* p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = (v >> 16) & 0xFF;
+    p[2] = (v >> 8) & 0xFF;
+    p[3] = v & 0xFF;
+}
+
+void put_le16(unsigned char* p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+void put_le32(unsigned char* p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+
+/**
+ * Map one row of heights to unsigned samples of Bytes bytes each, in either
+ * big-endian (PNG) or little-endian (raw) byte order.
+ */
+void quantize_row(const float* Row, int w, float Min, float Max, int Bytes, bool BigEndian, unsigned char* Out)
+{
+    float MaxV = Bytes == 1 ? 255.0f : 65535.0f;
+    float Scale = Max > Min ? MaxV / (Max - Min) : 0.0f;
+    for (int i = 0; i < w; ++i)
+    {
+        float q = (Row[i] - Min) * Scale;
+        uint32_t v = (uint32_t)(std::min(MaxV, std::max(0.0f, q)) + 0.5f);
+        if (Bytes == 1)
+            Out[i] = v;
+        else if (BigEndian)
+        {
+            Out[2 * i] = v >> 8;
+            Out[2 * i + 1] = v & 0xFF;
+        }
+        else
+            put_le16(Out + 2 * i, v);
+    }
+}
+
+
+int paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    return pb <= pc ? b : c;
+}
+
+/**
+ * Apply PNG filter F to Cur, given the previous row Prev (all zeros for the
+ * first row), writing the filter byte followed by the residuals into Out.
+ * Returns the sum of the absolute residuals, seen as signed bytes.
+ */
+unsigned long filter_row(int F, const unsigned char* Cur, const unsigned char* Prev, size_t n, int bpp, unsigned char* Out)
+{
+    Out[0] = F;
+    ++Out;
+    unsigned long cost = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        int a = i >= (size_t)bpp ? Cur[i - bpp] : 0;
+        int b = Prev[i];
+        int c = i >= (size_t)bpp ? Prev[i - bpp] : 0;
+        int pred = 0;
+        switch (F)
+        {
+        case 1: pred = a; break;
+        case 2: pred = b; break;
+        case 3: pred = (a + b) / 2; break;
+        case 4: pred = paeth(a, b, c); break;
+        default: break;
+        }
+        unsigned char r = Cur[i] - pred;
+        Out[i] = r;
+        cost += r < 128 ? r : 256 - r;
+    }
+    return cost;
+}
+
+
+/**
+ * A band of rows, filtered and compressed by one thread.
+ */
+struct PngBand
+{
+    int j0, j1;
+    std::vector<unsigned char> Comp;
+    uint32_t Adler;
+    size_t Size;
+};
+
+void encode_png_band(const HeightMap& HM, int Bytes, const PngOptions& Opts, PngBand& B)
+{
+    RT_PROFILE_SCOPE("png_band");
+    int w = HM.GetWidth();
+    size_t RowBytes = (size_t)w * Bytes;
+    const float* Data = HM.RawData();
+
+    std::vector<unsigned char> Prev(RowBytes, 0);
+    std::vector<unsigned char> Cur(RowBytes);
+    std::vector<unsigned char> Trial(RowBytes + 1);
+    std::vector<unsigned char> Filtered((B.j1 - B.j0) * (RowBytes + 1));
+    if (B.j0 > 0)
+        quantize_row(Data + (size_t)(B.j0 - 1) * w, w, HM.GetMin(), HM.GetMax(), Bytes, true, Prev.data());
+
+    for (int j = B.j0; j < B.j1; ++j)
+    {
+        quantize_row(Data + (size_t)j * w, w, HM.GetMin(), HM.GetMax(), Bytes, true, Cur.data());
+        unsigned char* Out = Filtered.data() + (j - B.j0) * (RowBytes + 1);
+        if (Opts.Filter != PngFilter::Adaptive)
+            filter_row((int)Opts.Filter, Cur.data(), Prev.data(), RowBytes, Bytes, Out);
+        else
+        {
+            unsigned long Best = filter_row(0, Cur.data(), Prev.data(), RowBytes, Bytes, Out);
+            for (int F = 1; F <= 4; ++F)
+            {
+                unsigned long Cost = filter_row(F, Cur.data(), Prev.data(), RowBytes, Bytes, Trial.data());
+                if (Cost < Best)
+                {
+                    Best = Cost;
+                    std::copy(Trial.begin(), Trial.end(), Out);
+                }
+            }
+        }
+        std::swap(Cur, Prev);
+    }
+
+    B.Size = Filtered.size();
+    B.Adler = adler32(1, Filtered.data(), Filtered.size());
+    B.Comp.clear();
+    deflate_chunk(Filtered.data(), Filtered.size(), Opts.Level, B.Comp);
+}
+
+
+// Write all rows as little-endian floats, band by band
+void write_float_rows(std::ofstream& of, const HeightMap& HM, int Rows)
+{
+    int w = HM.GetWidth();
+    int h = HM.GetHeight();
+    const float* Data = HM.RawData();
+    std::vector<unsigned char> Band((size_t)Rows * w * 4);
+    for (int j0 = 0; j0 < h; j0 += Rows)
+    {
+        int j1 = std::min(h, j0 + Rows);
+        size_t n = (size_t)(j1 - j0) * w;
+        const float* Src = Data + (size_t)j0 * w;
+        for (size_t k = 0; k < n; ++k)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, Src + k, 4);
+            put_le32(Band.data() + 4 * k, bits);
+        }
+        of.write((const char*)Band.data(), 4 * n);
+    }
+}
+
+
+void write_png_chunk(std::ofstream& of, const char* Type, const unsigned char* Data, size_t n)
+{
+    unsigned char hdr[8];
+    put_be32(hdr, (uint32_t)n);
+    std::memcpy(hdr + 4, Type, 4);
+    uint32_t crc = crc32(0, hdr + 4, 4);
+    crc = crc32(crc, Data, n);
+    unsigned char trl[4];
+    put_be32(trl, crc);
+
+    of.write((const char*)hdr, 8);
+    of.write((const char*)Data, n);
+    of.write((const char*)trl, 4);
+}
+
+} // namespace
+
+
+void export_hmap_png(const std::string& filename, const HeightMap& HM, int BitDepth, const PngOptions& Opts)
+{
+    RT_PROFILE_SCOPE("export_png");
+    if (BitDepth != 8 && BitDepth != 16)
+        throw std::runtime_error("PNG heightmaps can only have 8 or 16 bits per sample.");
+
+    int w = HM.GetWidth();
+    int h = HM.GetHeight();
+    int Bytes = BitDepth / 8;
+    size_t RowBytes = (size_t)w * Bytes;
+
+    std::ofstream of = open_output(filename);
+    const unsigned char Signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    of.write((const char*)Signature, 8);
+
+    unsigned char IHDR[13];
+    put_be32(IHDR, w);
+    put_be32(IHDR + 4, h);
+    IHDR[8] = BitDepth;
+    IHDR[9] = 0;        // grayscale
+    IHDR[10] = 0;       // deflate
+    IHDR[11] = 0;       // adaptive filtering
+    IHDR[12] = 0;       // no interlace
+    write_png_chunk(of, "IHDR", IHDR, 13);
+
+    std::vector<unsigned char> Comp;
+    zlib_header(Opts.Level, Comp);
+    write_png_chunk(of, "IDAT", Comp.data(), Comp.size());
+
+    // Bands are encoded in waves of one band per thread, and each wave is
+    // written in order as a sequence of IDAT chunks, so that memory stays
+    // bounded by the number of threads.
+    int nThreads = Opts.Threads > 0 ? Opts.Threads : std::max(1u, std::thread::hardware_concurrency());
+    int Rows = band_rows(RowBytes + 1);
+    int nBands = (h + Rows - 1) / Rows;
+    nThreads = std::max(1, std::min(nThreads, nBands));
+    std::vector<PngBand> Wave(nThreads);
+    uint32_t Adler = 1;
+
+    for (int b0 = 0; b0 < nBands; b0 += nThreads)
+    {
+        int nb = std::min(nThreads, nBands - b0);
+        for (int b = 0; b < nb; ++b)
+        {
+            Wave[b].j0 = (b0 + b) * Rows;
+            Wave[b].j1 = std::min(h, Wave[b].j0 + Rows);
+        }
+
+        std::vector<std::thread> Workers;
+        for (int b = 1; b < nb; ++b)
+            Workers.emplace_back(encode_png_band, std::cref(HM), Bytes, std::cref(Opts), std::ref(Wave[b]));
+        encode_png_band(HM, Bytes, Opts, Wave[0]);
+        for (auto& t : Workers)
+            t.join();
+
+        for (int b = 0; b < nb; ++b)
+        {
+            Adler = adler32_combine(Adler, Wave[b].Adler, Wave[b].Size);
+            write_png_chunk(of, "IDAT", Wave[b].Comp.data(), Wave[b].Comp.size());
+        }
+    }
+
+    Comp.clear();
+    zlib_trailer(Adler, Comp);
+    write_png_chunk(of, "IDAT", Comp.data(), Comp.size());
+    write_png_chunk(of, "IEND", nullptr, 0);
+
+    close_output(of);
+}
+
+
+void export_hmap_r16(const std::string& filename, const HeightMap& HM)
+{
+    RT_PROFILE_SCOPE("export_r16");
+    int w = HM.GetWidth();
+    int h = HM.GetHeight();
+    size_t RowBytes = (size_t)w * 2;
+    const float* Data = HM.RawData();
+
+    std::ofstream of = open_output(filename);
+    int Rows = band_rows(RowBytes);
+    std::vector<unsigned char> Band(Rows * RowBytes);
+    for (int j0 = 0; j0 < h; j0 += Rows)
+    {
+        int j1 = std::min(h, j0 + Rows);
+        for (int j = j0; j < j1; ++j)
+            quantize_row(Data + (size_t)j * w, w, HM.GetMin(), HM.GetMax(), 2, false, Band.data() + (j - j0) * RowBytes);
+        of.write((const char*)Band.data(), (j1 - j0) * RowBytes);
+    }
+    close_output(of);
+}
+
+
+void export_hmap_r32(const std::string& filename, const HeightMap& HM)
+{
+    RT_PROFILE_SCOPE("export_r32");
+    std::ofstream of = open_output(filename);
+    write_float_rows(of, HM, band_rows((size_t)HM.GetWidth() * 4));
+    close_output(of);
+}
+
+
+void export_hmap_tiff(const std::string& filename, const HeightMap& HM)
+{
+    RT_PROFILE_SCOPE("export_tiff");
+    int w = HM.GetWidth();
+    int h = HM.GetHeight();
+    size_t RowBytes = (size_t)w * 4;
+    int Rows = band_rows(RowBytes);
+    int nStrips = (h + Rows - 1) / Rows;
+
+    // Layout: header, IFD, strip offsets, strip byte counts, pixel data
+    const int nTags = 11;
+    uint32_t IFDOffset = 8;
+    uint32_t OffsetsOffset = IFDOffset + 2 + 12 * nTags + 4;
+    uint32_t CountsOffset = OffsetsOffset + 4 * nStrips;
+    uint64_t DataOffset = CountsOffset + 4 * nStrips;
+    if (DataOffset + RowBytes * h > 0xFFFFFFFFull)
+        throw std::runtime_error("Heightmap is too large for a TIFF file. Export it as .r32 instead.");
+
+    std::vector<unsigned char> Head(DataOffset, 0);
+    unsigned char* p = Head.data();
+    p[0] = 'I';
+    p[1] = 'I';
+    put_le16(p + 2, 42);
+    put_le32(p + 4, IFDOffset);
+
+    p = Head.data() + IFDOffset;
+    put_le16(p, nTags);
+    p += 2;
+    auto Tag = [&p](uint16_t Id, uint16_t Type, uint32_t Count, uint32_t Value)
+    {
+        put_le16(p, Id);
+        put_le16(p + 2, Type);
+        put_le32(p + 4, Count);
+        if (Type == 3 && Count == 1)
+            put_le16(p + 8, Value);
+        else
+            put_le32(p + 8, Value);
+        p += 12;
+    };
+    const uint16_t SHORT = 3;
+    const uint16_t LONG = 4;
+    Tag(256, LONG, 1, w);                                           // ImageWidth
+    Tag(257, LONG, 1, h);                                           // ImageLength
+    Tag(258, SHORT, 1, 32);                                         // BitsPerSample
+    Tag(259, SHORT, 1, 1);                                          // Compression: none
+    Tag(262, SHORT, 1, 1);                                          // Photometric: BlackIsZero
+    Tag(273, LONG, nStrips, nStrips == 1 ? DataOffset : OffsetsOffset);  // StripOffsets
+    Tag(277, SHORT, 1, 1);                                          // SamplesPerPixel
+    Tag(278, LONG, 1, Rows);                                        // RowsPerStrip
+    Tag(279, LONG, nStrips, nStrips == 1 ? RowBytes * h : CountsOffset); // StripByteCounts
+    Tag(284, SHORT, 1, 1);                                          // PlanarConfiguration
+    Tag(339, SHORT, 1, 3);                                          // SampleFormat: IEEE float
+    put_le32(p, 0);
+
+    for (int s = 0; s < nStrips; ++s)
+    {
+        int nr = std::min(Rows, h - s * Rows);
+        put_le32(Head.data() + OffsetsOffset + 4 * s, DataOffset + (uint64_t)s * Rows * RowBytes);
+        put_le32(Head.data() + CountsOffset + 4 * s, nr * RowBytes);
+    }
+
+    // Strips hold little-endian floats, exactly like the raw format
+    std::ofstream of = open_output(filename);
+    of.write((const char*)Head.data(), Head.size());
+    write_float_rows(of, HM, Rows);
+    close_output(of);
+}
+
+
+std::string export_hmap(const std::string& filename, HeightMap& HM, int BitDepth, const PngOptions& Opts)
+{
+    std::filesystem::path Path(filename);
+    std::string Ext = Path.extension().string();
+    int w = HM.GetWidth();
+    int h = HM.GetHeight();
+    if (Ext == ".rthm" && HM.IsMapped())
+        HM.Flush();
+    else if (Ext == ".png")
+        export_hmap_png(filename, HM, BitDepth, Opts);
+    else if (Ext == ".r16" || Ext == ".raw")
+        export_hmap_r16(filename, HM);
+    else if (Ext == ".r32")
+        export_hmap_r32(filename, HM);
+    else if (Ext == ".tif" || Ext == ".tiff")
+        export_hmap_tiff(filename, HM);
+    else if (Ext == ".hdr")
+        stbi_write_hdr(filename.c_str(), w, h, 1, HM.RawData());
+    else if (Ext == ".jpg" || Ext == ".jpeg" || Ext == ".bmp")
+    {
+        HM.Quantize();
+        if (Ext == ".bmp")
+            stbi_write_bmp(filename.c_str(), w, h, 1, HM.Quantized());
+        else
+            stbi_write_jpg(filename.c_str(), w, h, 1, HM.Quantized(), 90);
+    }
+    else
+    {
+        std::cerr << "Image format " << Path.extension() << " is not yet supported. Exporting as PNG." << std::endl;
+        std::string Png = Path.replace_extension(".png").string();
+        export_hmap_png(Png, HM, BitDepth, Opts);
+        return Png;
+    }
+    return filename;
+}
\ No newline at end of file
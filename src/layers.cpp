@@ -0,0 +1,149 @@
+/**
+ * @file        layers.cpp
+ *
+ * @brief       Implements LayerStack.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <layers.hpp>
+#include <profiler.hpp>
+#include <sstream>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RT_LAYERS_SSE
+#endif
+
+
+LayerStack::LayerStack(int Width, int Height)
+    : m_Bed(Width, Height), m_Voronoi(Width, Height), m_Perlin(Width, Height) { }
+
+int LayerStack::GetWidth() const { return m_Bed.GetWidth(); }
+int LayerStack::GetHeight() const { return m_Bed.GetHeight(); }
+
+HeightMap& LayerStack::Bed() { return m_Bed; }
+HeightMap& LayerStack::Voronoi() { return m_Voronoi; }
+HeightMap& LayerStack::Perlin() { return m_Perlin; }
+const HeightMap& LayerStack::Bed() const { return m_Bed; }
+const HeightMap& LayerStack::Voronoi() const { return m_Voronoi; }
+const HeightMap& LayerStack::Perlin() const { return m_Perlin; }
+
+
+namespace
+{
+
+// Out = B + vw * V + pw * P. Min and Max are extended with both partial sums,
+// which are the values the pipeline writes with add_voronoi() and add_perlin().
+void weighted_sum(const float* B, const float* V, const float* P, float vw, float pw, size_t n,
+                  float* Out, float& Min, float& Max)
+{
+    size_t k = 0;
+#ifdef RT_LAYERS_SSE
+    __m128 VW = _mm_set1_ps(vw);
+    __m128 PW = _mm_set1_ps(pw);
+    __m128 VMin = _mm_set1_ps(Min);
+    __m128 VMax = _mm_set1_ps(Max);
+    for (; k + 4 <= n; k += 4)
+    {
+        __m128 t1 = _mm_add_ps(_mm_loadu_ps(B + k), _mm_mul_ps(VW, _mm_loadu_ps(V + k)));
+        __m128 t2 = _mm_add_ps(t1, _mm_mul_ps(PW, _mm_loadu_ps(P + k)));
+        VMin = _mm_min_ps(VMin, _mm_min_ps(t1, t2));
+        VMax = _mm_max_ps(VMax, _mm_max_ps(t1, t2));
+        _mm_storeu_ps(Out + k, t2);
+    }
+    float Lanes[4];
+    _mm_storeu_ps(Lanes, VMin);
+    Min = std::min({ Lanes[0], Lanes[1], Lanes[2], Lanes[3] });
+    _mm_storeu_ps(Lanes, VMax);
+    Max = std::max({ Lanes[0], Lanes[1], Lanes[2], Lanes[3] });
+#endif
+    for (; k < n; ++k)
+    {
+        float t1 = B[k] + vw * V[k];
+        float t2 = t1 + pw * P[k];
+        Min = std::min(Min, std::min(t1, t2));
+        Max = std::max(Max, std::max(t1, t2));
+        Out[k] = t2;
+    }
+}
+
+// Row = (Hi - Row + Lo) + d, as HeightMap::Invert() followed by the delta ramp
+void invert_raise(float* Row, size_t n, float Lo, float Hi, float d, float& Min, float& Max)
+{
+    size_t k = 0;
+#ifdef RT_LAYERS_SSE
+    __m128 VLo = _mm_set1_ps(Lo);
+    __m128 VHi = _mm_set1_ps(Hi);
+    __m128 VD = _mm_set1_ps(d);
+    __m128 VMin = _mm_set1_ps(Min);
+    __m128 VMax = _mm_set1_ps(Max);
+    for (; k + 4 <= n; k += 4)
+    {
+        __m128 x = _mm_add_ps(_mm_add_ps(_mm_sub_ps(VHi, _mm_loadu_ps(Row + k)), VLo), VD);
+        VMin = _mm_min_ps(VMin, x);
+        VMax = _mm_max_ps(VMax, x);
+        _mm_storeu_ps(Row + k, x);
+    }
+    float Lanes[4];
+    _mm_storeu_ps(Lanes, VMin);
+    Min = std::min({ Lanes[0], Lanes[1], Lanes[2], Lanes[3] });
+    _mm_storeu_ps(Lanes, VMax);
+    Max = std::max({ Lanes[0], Lanes[1], Lanes[2], Lanes[3] });
+#endif
+    for (; k < n; ++k)
+    {
+        float x = Hi - Row[k] + Lo + d;
+        Min = std::min(Min, x);
+        Max = std::max(Max, x);
+        Row[k] = x;
+    }
+}
+
+} // namespace
+
+
+void compose_layers(const HeightMap& Bed, const HeightMap& Voronoi, const HeightMap& Perlin,
+                    float VoronoiWeight, float PerlinWeight, float PlaneDelta, HeightMap& Out)
+{
+    RT_PROFILE_SCOPE("compose_layers");
+    int w = Bed.GetWidth();
+    int h = Bed.GetHeight();
+    for (const HeightMap* L : { &Voronoi, &Perlin, (const HeightMap*)&Out })
+    {
+        if (L->GetWidth() != w || L->GetHeight() != h)
+        {
+            std::stringstream ss;
+            ss << "Cannot compose a " << w << "-by-" << h << " bed with a ";
+            ss << L->GetWidth() << "-by-" << L->GetHeight() << " heightmap.";
+            throw std::runtime_error(ss.str());
+        }
+    }
+
+    // The range starts from the one of the bed, like in the pipeline. The
+    // first pass reads every value before writing it, so Out can be Bed.
+    float Lo = Bed.GetMin();
+    float Hi = Bed.GetMax();
+    weighted_sum(Bed.RawData(), Voronoi.RawData(), Perlin.RawData(), VoronoiWeight, PerlinWeight,
+                 (size_t)w * h, Out.RawData(), Lo, Hi);
+
+    float Min = Lo;
+    float Max = Hi;
+    for (int j = 0; j < h; ++j)
+    {
+        float t = j / (float)(h - 1);
+        float d = PlaneDelta * (1 - t);
+        invert_raise(Out.RawData() + (size_t)j * w, w, Lo, Hi, d, Min, Max);
+    }
+    Out.SetRange(Min, Max);
+}
+
+
+void LayerStack::Compose(float VoronoiWeight, float PerlinWeight, float PlaneDelta, HeightMap& Out) const
+{
+    compose_layers(m_Bed, m_Voronoi, m_Perlin, VoronoiWeight, PerlinWeight, PlaneDelta, Out);
+}
\ No newline at end of file
@@ -11,11 +11,14 @@
  */
 #include <iostream>
 #include <parser.hpp>
-#include <geometry.hpp>
-#include <noises.hpp>
+#include <rtlib.hpp>
 #include <plane.hpp>
-#include <stb_image_write.h>
+#include <hmap_io.hpp>
+#include <profiler.hpp>
+#include <daemon.hpp>
+#include <tasks.hpp>
 #include <filesystem>
+#include <cstdlib>
 
 int main(int argc, const char* const argv[])
 {
@@ -25,6 +28,30 @@ int main(int argc, const char* const argv[])
         std::cerr << "Missing input configuration file." << std::endl;
         return -1;
     }
+
+    // Serve requests until shutdown
+    if (std::string(argv[1]) == "--daemon")
+    {
+        int Workers = 0;
+        if (argc == 5 && std::string(argv[3]) == "--workers")
+            Workers = std::atoi(argv[4]);
+        else if (argc != 3)
+        {
+            std::cerr << "Usage: RiverGen --daemon <socket> [--workers N]" << std::endl;
+            return -1;
+        }
+        try
+        {
+            run_daemon(argv[2], Workers);
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << e.what() << '\n';
+            return -1;
+        }
+        return 0;
+    }
+
     RiverParams Params;
     try
     {
@@ -35,57 +62,76 @@ int main(int argc, const char* const argv[])
         std::cerr << e.what() << '\n';
         return -1;
     }
+    for (int i = 2; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--trace" && i + 1 < argc)
+            Params.OutTrace = argv[++i];
+        else
+        {
+            std::cerr << "Unknown argument " << argv[i] << '.' << std::endl;
+            return -1;
+        }
+    }
+    Profiler::Enable(!Params.OutTrace.empty());
 
 
-    // Compute the river
-    HeightMap HM = river(Params.Width, Params.Height, 
-                         Params.RiverNodes, Params.RiverSamples, Params.RiverThickness,
-                         Params.GaussKSX, Params.GaussKSY, Params.GaussSigma,
-                         Params.RiverSeed);
+    try
+    {
+        // Maps saved as .rthm are generated directly into the memory-mapped output file
+        std::filesystem::path OutImg(Params.OutHMap);
+        HeightMap HM = OutImg.extension() == ".rthm" ?
+                       HeightMap::CreateMapped(Params.OutHMap, Params.Width, Params.Height) :
+                       HeightMap(Params.Width, Params.Height);
 
-    // Add noises
-    add_voronoi(HM, Params.VoronoiWeight, Params.VoronoiScale);
-    add_perlin(HM, Params.PerlinWeight, Params.PerlinScale, Params.PerlinOctaves);
-    HM.Invert();
+        // Generate the terrain, with the noise layers overlapping the river
+        ThreadPool Pool;
+        RiverGenerator Gen(&Pool);
+        Gen.Generate(Params, HM);
 
-    // Add delta height
-    for (int j = 0; j < HM.GetHeight(); ++j)
-    {
-        float t = j / (float)(HM.GetHeight() - 1);
-        float d = Params.PlaneDelta * (1 - t);
-        for (int i = 0; i < HM.GetWidth(); ++i)
-            HM.Set(i, j, HM(i, j) + d);
-    }
 
+        // The image is written while the plane is triangulated and exported
+        TaskGraph Export;
+        Export.Add([&]() { Params.OutHMap = export_hmap(Params.OutHMap, HM, Params.OutBitDepth, Params.Png); });
 
-    // Save image
-    HM.Quantize();
-    std::filesystem::path OutImg(Params.OutHMap);
-    if (OutImg.extension() == ".png")
-        stbi_write_png(Params.OutHMap.c_str(), Params.Width, Params.Height, 1, HM.Quantized(), Params.Width);
-    else if(OutImg.extension() == ".jpg" || OutImg.extension() == ".jpeg")
-        stbi_write_jpg(Params.OutHMap.c_str(), Params.Width, Params.Height, 1, HM.Quantized(), 90);
-    else if (OutImg.extension() == ".bmp")
-        stbi_write_bmp(Params.OutHMap.c_str(), Params.Width, Params.Height, 1, HM.Quantized());
-    else if (OutImg.extension() == ".hdr")
-        stbi_write_hdr(Params.OutHMap.c_str(), Params.Width, Params.Height, 1, HM.RawData());
-    else
+        float* verts;
+        unsigned int* tris;
+        int nverts = Params.PlaneWidth * Params.PlaneHeight;
+        int ntris = 0;
+        int Plane = Export.Add([&]()
+        {
+            triangulate_plane(HM, Params.PlaneWidth, Params.PlaneHeight, ntris, &verts, &tris, Params.PlaneFilter);
+
+            // Normalize the mesh heights rather than the map, which may be the mapped output
+            float zmin = HM.GetMin();
+            float zdiff = HM.GetMax() - zmin;
+            for (int i = 0; i < nverts; ++i)
+                verts[3 * i + 2] = (verts[3 * i + 2] - zmin) / zdiff;
+        });
+        Export.Add([&]() { export_plane_as_obj(Params.OutMesh, nverts, ntris, verts, tris); }, { Plane });
+        Export.Run(&Pool);
+    }
+    catch(const std::exception& e)
     {
-        std::cerr << "Image format " << OutImg.extension() << " is not yet supported. Exporting as PNG." << std::endl;
-        Params.OutHMap = OutImg.replace_extension(".png").string();
-        stbi_write_png(Params.OutHMap.c_str(), Params.Width, Params.Height, 1, HM.Quantized(), Params.Width);
+        std::cerr << e.what() << '\n';
+        return -1;
     }
+    
 
+    // Report timings
+    if (Profiler::IsEnabled())
+    {
+        Profiler::PrintSummary(std::cout);
+        try
+        {
+            Profiler::WriteTrace(Params.OutTrace);
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << e.what() << '\n';
+            return -1;
+        }
+    }
 
-    // Export plane
-    float* verts;
-    unsigned int* tris;
-    int nverts = Params.PlaneWidth * Params.PlaneHeight;
-    int ntris = 0;
-    HM.Normalize();
-    triangulate_plane(HM, Params.PlaneWidth, Params.PlaneHeight, ntris, &verts, &tris);
-    export_plane_as_obj(Params.OutMesh, nverts, ntris, verts, tris);
-    
 
     return 0;
 }
\ No newline at end of file
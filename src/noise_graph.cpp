@@ -0,0 +1,516 @@
+/**
+ * @file        noise_graph.cpp
+ *
+ * @brief       Implements the compilation and evaluation of noise graphs.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <noise_graph.hpp>
+#include <noises.hpp>
+#include <profiler.hpp>
+#include <stb_perlin.h>
+#include <sstream>
+#include <algorithm>
+#include <memory>
+#include <map>
+#include <cmath>
+
+
+NoiseOp parse_noise_op(const std::string& name)
+{
+    if (name == "const")
+        return NoiseOp::Const;
+    if (name == "fbm")
+        return NoiseOp::FBM;
+    if (name == "ridged")
+        return NoiseOp::Ridged;
+    if (name == "cellular")
+        return NoiseOp::Cellular;
+    if (name == "spectral")
+        return NoiseOp::Spectral;
+    if (name == "warp")
+        return NoiseOp::Warp;
+    if (name == "add")
+        return NoiseOp::Add;
+    if (name == "mul")
+        return NoiseOp::Mul;
+    if (name == "clamp")
+        return NoiseOp::Clamp;
+
+    std::stringstream ss;
+    ss << "Unknown noise node type \"" << name << "\".";
+    throw std::runtime_error(ss.str());
+}
+
+
+NoiseGraph::NoiseGraph() : m_Output(-1) { }
+
+int NoiseGraph::Add(const NoiseNode& Node)
+{
+    int n = m_Nodes.size();
+    int Inputs = 0;
+    if (Node.Op == NoiseOp::Warp || Node.Op == NoiseOp::Clamp)
+        Inputs = 1;
+    else if (Node.Op == NoiseOp::Add || Node.Op == NoiseOp::Mul)
+        Inputs = 2;
+    int In[2] = { Node.A, Node.B };
+    for (int k = 0; k < Inputs; ++k)
+    {
+        if (In[k] < 0 || In[k] >= n)
+        {
+            std::stringstream ss;
+            ss << "Node " << n << " of the noise graph cannot read from node " << In[k];
+            ss << ", which does not come before it.";
+            throw std::runtime_error(ss.str());
+        }
+    }
+    m_Nodes.push_back(Node);
+    return n;
+}
+
+void NoiseGraph::SetOutput(int Node)
+{
+    if (Node < 0 || Node >= (int)m_Nodes.size())
+    {
+        std::stringstream ss;
+        ss << "Node " << Node << " is not part of the noise graph.";
+        throw std::runtime_error(ss.str());
+    }
+    m_Output = Node;
+}
+
+bool NoiseGraph::IsEmpty() const { return m_Nodes.empty(); }
+int NoiseGraph::GetOutput() const { return m_Output; }
+const std::vector<NoiseNode>& NoiseGraph::GetNodes() const { return m_Nodes; }
+
+
+namespace
+{
+
+// Samples per block, few enough for all the registers to stay in the cache
+const int BlockSize = 256;
+
+struct Instr;
+typedef void (*Kernel)(const Instr& I, float* R, int n);
+
+// Instructions read and write registers of BlockSize samples. The map
+// coordinates of the block are in registers 0 and 1.
+struct Instr
+{
+    Kernel Run;
+    int Out;
+    int Out2;                   // Displaced v of a warp
+    int U;
+    int V;
+    int A;
+    int B;
+    float C;                    // Constant operands
+    float C2;
+    const NoiseNode* Node;
+    const HeightMap* Field;
+};
+
+float* reg(float* R, int r)
+{
+    return R + (size_t)r * BlockSize;
+}
+
+
+// Octave i has frequency Lacunarity^i, amplitude Gain^i and seed Seed + i, as
+// in stb_perlin_fbm_noise3(), which uses seed i
+float fbm(float u, float v, const NoiseNode& N, int Seed)
+{
+    float f = 1.0f;
+    float a = 1.0f;
+    float Sum = 0.0f;
+    for (int o = 0; o < N.Octaves; ++o)
+    {
+        Sum += stb_perlin_noise3_seed(u * f, v * f, 0.0f, 0, 0, 0, Seed + o) * a;
+        f *= N.Lacunarity;
+        a *= N.Gain;
+    }
+    return Sum;
+}
+
+// Each ridge octave is also weighted by the previous one, as in stb_perlin_ridge_noise3()
+float ridged(float u, float v, const NoiseNode& N)
+{
+    float f = 1.0f;
+    float a = 1.0f;
+    float Prev = 1.0f;
+    float Sum = 0.0f;
+    for (int o = 0; o < N.Octaves; ++o)
+    {
+        float r = N.Offset - std::abs(stb_perlin_noise3_seed(u * f, v * f, 0.0f, 0, 0, 0, N.Seed + o));
+        r = r * r;
+        Sum += r * a * Prev;
+        Prev = r;
+        f *= N.Lacunarity;
+        a *= N.Gain;
+    }
+    return Sum;
+}
+
+
+void kernel_const(const Instr& I, float* R, int n)
+{
+    std::fill(reg(R, I.Out), reg(R, I.Out) + n, I.C);
+}
+
+template<NoiseOp Op>
+void kernel_generator(const Instr& I, float* R, int n)
+{
+    const NoiseNode& N = *I.Node;
+    const float* U = reg(R, I.U);
+    const float* V = reg(R, I.V);
+    float* Out = reg(R, I.Out);
+    for (int k = 0; k < n; ++k)
+    {
+        float u = U[k] * N.Scale;
+        float v = V[k] * N.Scale;
+        if (Op == NoiseOp::FBM)
+            Out[k] = fbm(u, v, N, N.Seed);
+        else if (Op == NoiseOp::Ridged)
+            Out[k] = ridged(u, v, N);
+        else
+            Out[k] = voronoi_distance(u, v, N.Seed);
+    }
+}
+
+// The spectral field is periodic, so it is sampled bilinearly with wrap-around
+void kernel_spectral(const Instr& I, float* R, int n)
+{
+    const HeightMap& F = *I.Field;
+    int fw = F.GetWidth();
+    int fh = F.GetHeight();
+    const float* D = F.RawData();
+    const float* U = reg(R, I.U);
+    const float* V = reg(R, I.V);
+    float* Out = reg(R, I.Out);
+    // One period of the field is fw by fh texels, so that u and u + 1 / Scale
+    // land on the same texel
+    float sx = I.Node->Scale * fw;
+    float sy = I.Node->Scale * fh;
+    auto Wrap = [](float x, int n)
+    {
+        int i = (int)(x - n * std::floor(x / n));
+        return i >= n ? i - n : i;
+    };
+    for (int k = 0; k < n; ++k)
+    {
+        float x = U[k] * sx;
+        float y = V[k] * sy;
+        float x0 = std::floor(x);
+        float y0 = std::floor(y);
+        float tx = x - x0;
+        float ty = y - y0;
+        int i0 = Wrap(x0, fw);
+        int j0 = Wrap(y0, fh);
+        int i1 = i0 + 1 < fw ? i0 + 1 : 0;
+        int j1 = j0 + 1 < fh ? j0 + 1 : 0;
+        const float* Row0 = D + (size_t)j0 * fw;
+        const float* Row1 = D + (size_t)j1 * fw;
+        float Top = Row0[i0] + tx * (Row0[i1] - Row0[i0]);
+        float Bottom = Row1[i0] + tx * (Row1[i1] - Row1[i0]);
+        Out[k] = Top + ty * (Bottom - Top);
+    }
+}
+
+// The displacements are two FBM fields with different seeds
+void kernel_warp(const Instr& I, float* R, int n)
+{
+    const NoiseNode& N = *I.Node;
+    const float* U = reg(R, I.U);
+    const float* V = reg(R, I.V);
+    float* OutU = reg(R, I.Out);
+    float* OutV = reg(R, I.Out2);
+    for (int k = 0; k < n; ++k)
+    {
+        float u = U[k] * N.Scale;
+        float v = V[k] * N.Scale;
+        OutU[k] = U[k] + N.Amount * fbm(u, v, N, N.Seed);
+        OutV[k] = V[k] + N.Amount * fbm(u, v, N, N.Seed + 101);
+    }
+}
+
+struct AddOp { static float Apply(float a, float b) { return a + b; } };
+struct MulOp { static float Apply(float a, float b) { return a * b; } };
+
+template<typename Op, bool ConstB>
+void kernel_binary(const Instr& I, float* R, int n)
+{
+    const float* A = reg(R, I.A);
+    const float* B = reg(R, ConstB ? I.A : I.B);
+    float* Out = reg(R, I.Out);
+    for (int k = 0; k < n; ++k)
+        Out[k] = Op::Apply(A[k], ConstB ? I.C : B[k]);
+}
+
+// A weighted term fused with the sum it enters, Out = A * C + B
+template<bool ConstB>
+void kernel_muladd(const Instr& I, float* R, int n)
+{
+    const float* A = reg(R, I.A);
+    const float* B = reg(R, ConstB ? I.A : I.B);
+    float* Out = reg(R, I.Out);
+    for (int k = 0; k < n; ++k)
+        Out[k] = A[k] * I.C + (ConstB ? I.C2 : B[k]);
+}
+
+void kernel_clamp(const Instr& I, float* R, int n)
+{
+    const float* A = reg(R, I.A);
+    float* Out = reg(R, I.Out);
+    for (int k = 0; k < n; ++k)
+        Out[k] = std::min(std::max(A[k], I.C), I.C2);
+}
+
+
+// A node compiles to a register, or to a constant that is folded into the
+// instructions that read it
+struct Operand
+{
+    int Reg;
+    float Value;
+
+    bool IsConst() const { return Reg < 0; }
+};
+
+Operand constant(float Value) { return { -1, Value }; }
+Operand variable(int Reg) { return { Reg, 0.0f }; }
+
+
+struct Program
+{
+    std::vector<Instr> Code;
+    std::vector<std::unique_ptr<HeightMap>> Fields;
+    int Registers = 2;
+};
+
+class Compiler
+{
+private:
+    const std::vector<NoiseNode>& m_Nodes;
+    std::vector<int> m_Uses;
+    std::map<std::pair<int, int>, Operand> m_Done;
+    int m_Width;
+    int m_Height;
+    Program& m_Prog;
+
+    Instr Make(Kernel Run, const NoiseNode* Node, int U, int V)
+    {
+        Instr I = { };
+        I.Run = Run;
+        I.Out = m_Prog.Registers++;
+        I.Out2 = -1;
+        I.U = U;
+        I.V = V;
+        I.A = -1;
+        I.B = -1;
+        I.Node = Node;
+        return I;
+    }
+
+    Operand Emit(const Instr& I)
+    {
+        m_Prog.Code.push_back(I);
+        return variable(I.Out);
+    }
+
+    // Both operations are commutative, so constants are moved to the right
+    template<typename Op>
+    Operand Binary(Operand a, Operand b, float Identity)
+    {
+        if (a.IsConst() && b.IsConst())
+            return constant(Op::Apply(a.Value, b.Value));
+        if (a.IsConst())
+            std::swap(a, b);
+        if (b.IsConst() && b.Value == Identity)
+            return a;
+        Instr I = Make(b.IsConst() ? kernel_binary<Op, true> : kernel_binary<Op, false>, nullptr, -1, -1);
+        I.A = a.Reg;
+        I.B = b.Reg;
+        I.C = b.Value;
+        return Emit(I);
+    }
+
+    // A product of a register and a constant that feeds only this sum is fused with it
+    bool FuseMulAdd(int Term, int Other, int U, int V, Operand& Result)
+    {
+        const NoiseNode& M = m_Nodes[Term];
+        if (M.Op != NoiseOp::Mul || m_Uses[Term] != 1)
+            return false;
+        Operand x = Compile(M.A, U, V);
+        Operand c = Compile(M.B, U, V);
+        if (x.IsConst() == c.IsConst())
+            return false;
+        if (x.IsConst())
+            std::swap(x, c);
+        Operand y = Compile(Other, U, V);
+        Instr I = Make(y.IsConst() ? kernel_muladd<true> : kernel_muladd<false>, nullptr, -1, -1);
+        I.A = x.Reg;
+        I.B = y.Reg;
+        I.C = c.Value;
+        I.C2 = y.Value;
+        Result = Emit(I);
+        return true;
+    }
+
+public:
+    // Nodes count their consumers among the nodes that reach the output
+    Compiler(const std::vector<NoiseNode>& Nodes, int Output, int Width, int Height, Program& Prog)
+        : m_Nodes(Nodes), m_Uses(Nodes.size(), 0), m_Width(Width), m_Height(Height), m_Prog(Prog)
+    {
+        std::vector<bool> Reached(Nodes.size(), false);
+        Reached[Output] = true;
+        for (int n = Output; n >= 0; --n)
+        {
+            if (!Reached[n])
+                continue;
+            for (int In : { Nodes[n].A, Nodes[n].B })
+            {
+                if (In < 0)
+                    continue;
+                Reached[In] = true;
+                m_Uses[In]++;
+            }
+        }
+        m_Prog.Fields.resize(Nodes.size());
+    }
+
+    // Nodes are compiled once for every pair of coordinate registers they are
+    // evaluated at, which only differ under warps
+    Operand Compile(int Node, int U, int V)
+    {
+        auto Key = std::make_pair(Node, U);
+        auto Found = m_Done.find(Key);
+        if (Found != m_Done.end())
+            return Found->second;
+
+        const NoiseNode& N = m_Nodes[Node];
+        Operand Result;
+        switch (N.Op)
+        {
+        case NoiseOp::Const:
+            Result = constant(N.Value);
+            break;
+        case NoiseOp::FBM:
+            Result = Emit(Make(kernel_generator<NoiseOp::FBM>, &N, U, V));
+            break;
+        case NoiseOp::Ridged:
+            Result = Emit(Make(kernel_generator<NoiseOp::Ridged>, &N, U, V));
+            break;
+        case NoiseOp::Cellular:
+            Result = Emit(Make(kernel_generator<NoiseOp::Cellular>, &N, U, V));
+            break;
+        case NoiseOp::Spectral:
+        {
+            // The field does not depend on the coordinates, so it is synthesized once
+            std::unique_ptr<HeightMap>& F = m_Prog.Fields[Node];
+            if (F == nullptr)
+                F.reset(new HeightMap(spectral(m_Width, m_Height, N.Beta, N.Seed)));
+            Instr I = Make(kernel_spectral, &N, U, V);
+            I.Field = F.get();
+            Result = Emit(I);
+            break;
+        }
+        case NoiseOp::Warp:
+        {
+            Instr I = Make(kernel_warp, &N, U, V);
+            I.Out2 = m_Prog.Registers++;
+            Emit(I);
+            Result = Compile(N.A, I.Out, I.Out2);
+            break;
+        }
+        case NoiseOp::Add:
+            if (!FuseMulAdd(N.A, N.B, U, V, Result) && !FuseMulAdd(N.B, N.A, U, V, Result))
+                Result = Binary<AddOp>(Compile(N.A, U, V), Compile(N.B, U, V), 0.0f);
+            break;
+        case NoiseOp::Mul:
+            Result = Binary<MulOp>(Compile(N.A, U, V), Compile(N.B, U, V), 1.0f);
+            break;
+        case NoiseOp::Clamp:
+        {
+            Operand a = Compile(N.A, U, V);
+            if (a.IsConst())
+            {
+                Result = constant(std::min(std::max(a.Value, N.Min), N.Max));
+                break;
+            }
+            Instr I = Make(kernel_clamp, nullptr, -1, -1);
+            I.A = a.Reg;
+            I.C = N.Min;
+            I.C2 = N.Max;
+            Result = Emit(I);
+            break;
+        }
+        }
+        m_Done[Key] = Result;
+        return Result;
+    }
+
+    // The output always ends up in a register
+    int CompileOutput(int Output)
+    {
+        Operand Out = Compile(Output, 0, 1);
+        if (!Out.IsConst())
+            return Out.Reg;
+        Instr I = Make(kernel_const, nullptr, -1, -1);
+        I.C = Out.Value;
+        return Emit(I).Reg;
+    }
+};
+
+} // namespace
+
+
+// The graph is compiled for every map, since spectral nodes depend on its size
+void NoiseGraph::Evaluate(HeightMap& HM, float alpha) const
+{
+    RT_PROFILE_SCOPE("noise_graph");
+    if (m_Output < 0)
+        throw std::runtime_error("The noise graph has no output node.");
+    int w = HM.GetWidth();
+    int h = HM.GetHeight();
+
+    Program Prog;
+    int Out = Compiler(m_Nodes, m_Output, w, h, Prog).CompileOutput(m_Output);
+    RT_PROFILE_COUNT("noise_graph.instructions", (int64_t)Prog.Code.size());
+
+    std::vector<float> R((size_t)Prog.Registers * BlockSize);
+    float* U = reg(R.data(), 0);
+    float* V = reg(R.data(), 1);
+    const float* Res = reg(R.data(), Out);
+    float* Data = HM.RawData();
+    float Min = HM.GetMin();
+    float Max = HM.GetMax();
+    for (int j = 0; j < h; ++j)
+    {
+        float v = j / (float)(h - 1);
+        for (int i0 = 0; i0 < w; i0 += BlockSize)
+        {
+            int n = std::min(BlockSize, w - i0);
+            for (int k = 0; k < n; ++k)
+            {
+                U[k] = (i0 + k) / (float)(w - 1);
+                V[k] = v;
+            }
+            for (const Instr& I : Prog.Code)
+                I.Run(I, R.data(), n);
+
+            float* Row = Data + (size_t)j * w + i0;
+            for (int k = 0; k < n; ++k)
+            {
+                float x = Row[k] + alpha * Res[k];
+                Min = std::min(Min, x);
+                Max = std::max(Max, x);
+                Row[k] = x;
+            }
+        }
+    }
+    HM.SetRange(Min, Max);
+}
\ No newline at end of file
@@ -15,10 +15,14 @@
  * @date        2023-09-05
  */
 #include <noises.hpp>
+#include <resample.hpp>
+#include <profiler.hpp>
 #include <stb_perlin.h>
 #include <iostream>
 #include <cmath>
 #include <limits>
+#include <vector>
+#include <algorithm>
 
 #define rot(x, k) (((x) << (k)) | ((x) >> (32 - (k))))
 
@@ -128,10 +132,10 @@ void hash_uint2_to_float2(unsigned int i, unsigned int j, float& x, float& y)
 }
 
 
-HeightMap perlin(int width, int height, float scale, int octaves)
+HeightMap perlin(int width, int height, float scale, int octaves, bool Multires)
 {
     HeightMap HM(width, height);
-    add_perlin(HM, 1.0f, scale, octaves);
+    add_perlin(HM, 1.0f, scale, octaves, Multires);
     return HM;
 }
 
@@ -143,8 +147,89 @@ HeightMap voronoi(int width, int height, float scale)
 }
 
 
-void add_perlin(HeightMap& HM, float alpha, float scale, int octaves)
+namespace
 {
+
+// Octave i of stb_perlin_fbm_noise3(u, v, 0, 2, 0.5, octaves), which has
+// frequency f = 2^i, amplitude 1 / f and seed i
+float perlin_octave(float u, float v, int i, float f)
+{
+    return stb_perlin_noise3_seed(u * f, v * f, 0.0f, 0, 0, 0, i) * (1.0f / f);
+}
+
+// Samples of the coarse grids per period of the noise lattice
+const int PerlinSamplesPerUnit = 8;
+
+// The octaves are accumulated on grids of PerlinSamplesPerUnit samples per
+// period of their lattice, each twice as fine as the previous one, and every
+// grid is upsampled bicubically into the next one. The octaves whose grid would
+// cover more than a quarter of the map are evaluated at every pixel instead.
+void add_perlin_multires(HeightMap& HM, float alpha, float scale, int octaves)
+{
+    int w = HM.GetWidth();
+    int h = HM.GetHeight();
+    int Base = std::max(1, (int)std::ceil(scale * PerlinSamplesPerUnit));
+
+    std::vector<float> Grid;
+    std::vector<float> Next;
+    int gw = 0;
+    int gh = 0;
+    int Coarse = 0;
+    for (; Coarse < octaves; ++Coarse)
+    {
+        // Grids of n intervals nest into those of 2n, until they reach the map
+        int64_t Intervals = (int64_t)Base << std::min(Coarse, 30);
+        int nw = (int)std::min<int64_t>(w, Intervals + 1);
+        int nh = (int)std::min<int64_t>(h, Intervals + 1);
+        if ((int64_t)nw * nh * 4 > (int64_t)w * h)
+            break;
+        Next.resize((size_t)nw * nh);
+        if (Coarse == 0)
+            std::fill(Next.begin(), Next.end(), 0.0f);
+        else
+            resample(Grid.data(), gw, gh, Next.data(), nw, nh, ResampleFilter::Bicubic);
+        float f = std::ldexp(1.0f, Coarse);
+        for (int j = 0; j < nh; ++j)
+        {
+            float v = j / (float)(nh - 1) * scale;
+            for (int i = 0; i < nw; ++i)
+                Next[(size_t)j * nw + i] += perlin_octave(i / (float)(nw - 1) * scale, v, Coarse, f);
+        }
+        Grid.swap(Next);
+        gw = nw;
+        gh = nh;
+    }
+    RT_PROFILE_COUNT("perlin.coarse_octaves", Coarse);
+
+    std::vector<float> Low((size_t)w * h, 0.0f);
+    if (Coarse > 0)
+        resample(Grid.data(), gw, gh, Low.data(), w, h, ResampleFilter::Bicubic);
+    for (int j = 0; j < h; ++j)
+    {
+        float v = j / (float)(h - 1) * scale;
+        for (int i = 0; i < w; ++i)
+        {
+            float u = i / (float)(w - 1) * scale;
+            float value = Low[(size_t)j * w + i];
+            float f = std::ldexp(1.0f, Coarse);
+            for (int k = Coarse; k < octaves; ++k, f *= 2.0f)
+                value += perlin_octave(u, v, k, f);
+            HM.Set(i, j, HM(i, j) + alpha * value);
+        }
+    }
+}
+
+} // namespace
+
+
+void add_perlin(HeightMap& HM, float alpha, float scale, int octaves, bool Multires)
+{
+    RT_PROFILE_SCOPE("perlin");
+    if (Multires)
+    {
+        add_perlin_multires(HM, alpha, scale, octaves);
+        return;
+    }
     float u, v;
     for (int j = 0; j < HM.GetHeight(); ++j)
     {
@@ -162,8 +247,38 @@ void add_perlin(HeightMap& HM, float alpha, float scale, int octaves)
 }
 
 
+float voronoi_distance(float u, float v, unsigned int seed)
+{
+    float value = std::numeric_limits<float>::infinity();
+    int cell_x = std::floor(u);
+    int cell_y = std::floor(v);
+    float x = 0.0f;
+    float y = 0.0f;
+    for (int dx = -1; dx <= 1; ++dx)
+    {
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            // Seed 0 keeps the points of the original Voronoi noise
+            if (seed == 0)
+                hash_uint2_to_float2(cell_x + dx, cell_y + dy, x, y);
+            else
+            {
+                x = hash_uint3_to_float(cell_x + dx, cell_y + dy, 2 * seed);
+                y = hash_uint3_to_float(cell_x + dx, cell_y + dy, 2 * seed + 1);
+            }
+            x += cell_x + dx;
+            y += cell_y + dy;
+            float d = (x - u) * (x - u) + (y - v) * (y - v);
+            value = std::min(value, d);
+        }
+    }
+    return std::sqrt(value);
+}
+
+
 void add_voronoi(HeightMap& HM, float alpha, float scale)
 {
+    RT_PROFILE_SCOPE("voronoi");
     float u, v;
     for (int j = 0; j < HM.GetHeight(); ++j)
     {
@@ -174,24 +289,7 @@ void add_voronoi(HeightMap& HM, float alpha, float scale)
             u = i / (float)(HM.GetWidth() - 1);
             u *= scale;
 
-            float value = std::numeric_limits<float>::infinity();
-            int cell_x = std::floor(u);
-            int cell_y = std::floor(v);
-            float x = 0.0f;
-            float y = 0.0f;
-            for (int dx = -1; dx <= 1; ++dx)
-            {
-                for (int dy = -1; dy <= 1; ++dy)
-                {
-                    hash_uint2_to_float2(cell_x + dx, cell_y + dy, x, y);
-                    x += cell_x + dx;
-                    y += cell_y + dy;
-                    float d = (x - u) * (x - u) + (y - v) * (y - v);
-                    value = std::min(value, d);
-                }
-            }
-
-            HM.Set(i, j, HM(i, j) + alpha * std::sqrt(value));
+            HM.Set(i, j, HM(i, j) + alpha * voronoi_distance(u, v));
         }
     }
 }
\ No newline at end of file
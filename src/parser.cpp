@@ -13,6 +13,8 @@
 #include <filesystem>
 #include <algorithm>
 #include <cctype>
+#include <map>
+#include <set>
 
 char my_tolower(char c)
 {
@@ -33,7 +35,11 @@ RiverParams parse_river_params(const std::string& filename)
     nlohmann::json j = nlohmann::json::parse(stream);
     stream.close();
 
+    return parse_river_params(j, filename);
+}
 
+RiverParams parse_river_params(const nlohmann::json& j, const std::string& filename, bool RequireOutput)
+{
     RiverParams params;
     // Image size
     if (j.contains("size"))
@@ -89,113 +95,142 @@ RiverParams parse_river_params(const std::string& filename)
     }
 
 
+    // A noise graph replaces the Perlin and Voronoi layers, which are then optional
+    bool HasGraph = j.contains("noise_graph");
+    if (HasGraph)
+        params.Noise = parse_noise_graph(j["noise_graph"], filename);
+
+
     // Perlin noise settings
-    if (!j.contains("perlin"))
-    {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "File must contains attribute \"perlin\".";
-        throw std::runtime_error(ss.str());
-    }
-    if (!j["perlin"].is_object())
-    {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "Attribute \"perlin\" must be an object.";
-        throw std::runtime_error(ss.str());
-    }
-    if (!j["perlin"].contains("weight"))
+    params.PerlinWeight = 0.0f;
+    params.PerlinScale = 0.0f;
+    params.PerlinOctaves = 0;
+    params.PerlinMultires = false;
+    if (!HasGraph || j.contains("perlin"))
     {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "Attribute \"perlin\" must contain sub-attribute \"weight\".";
-        throw std::runtime_error(ss.str());
-    }
-    if (!j["perlin"]["weight"].is_number_float())
-    {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "Sub-attribute \"weight\" inside \"perlin\" must be a float.";
-        throw std::runtime_error(ss.str());
-    }
-    if (!j["perlin"].contains("scale"))
-    {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "Attribute \"perlin\" must contain sub-attribute \"scale\".";
-        throw std::runtime_error(ss.str());
-    }
-    if (!j["perlin"]["scale"].is_number_float())
-    {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "Sub-attribute \"scale\" inside \"perlin\" must be a float.";
-        throw std::runtime_error(ss.str());
-    }
-    if (!j["perlin"].contains("octaves"))
-    {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "Attribute \"perlin\" must contain sub-attribute \"octaves\".";
-        throw std::runtime_error(ss.str());
-    }
-    if (!j["perlin"]["octaves"].is_number_integer())
-    {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "Sub-attribute \"octaves\" inside \"perlin\" must be an integer.";
-        throw std::runtime_error(ss.str());
+        if (!j.contains("perlin"))
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "File must contains attribute \"perlin\".";
+            throw std::runtime_error(ss.str());
+        }
+        if (!j["perlin"].is_object())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Attribute \"perlin\" must be an object.";
+            throw std::runtime_error(ss.str());
+        }
+        if (!j["perlin"].contains("weight"))
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Attribute \"perlin\" must contain sub-attribute \"weight\".";
+            throw std::runtime_error(ss.str());
+        }
+        if (!j["perlin"]["weight"].is_number_float())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"weight\" inside \"perlin\" must be a float.";
+            throw std::runtime_error(ss.str());
+        }
+        if (!j["perlin"].contains("scale"))
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Attribute \"perlin\" must contain sub-attribute \"scale\".";
+            throw std::runtime_error(ss.str());
+        }
+        if (!j["perlin"]["scale"].is_number_float())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"scale\" inside \"perlin\" must be a float.";
+            throw std::runtime_error(ss.str());
+        }
+        if (!j["perlin"].contains("octaves"))
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Attribute \"perlin\" must contain sub-attribute \"octaves\".";
+            throw std::runtime_error(ss.str());
+        }
+        if (!j["perlin"]["octaves"].is_number_integer())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"octaves\" inside \"perlin\" must be an integer.";
+            throw std::runtime_error(ss.str());
+        }
+        params.PerlinWeight = j["perlin"]["weight"];
+        params.PerlinScale = j["perlin"]["scale"];
+        params.PerlinOctaves = j["perlin"]["octaves"];
+        if (j["perlin"].contains("multires"))
+        {
+            if (!j["perlin"]["multires"].is_boolean())
+            {
+                std::stringstream ss;
+                ss << "JSON parse error on file " << filename << std::endl;
+                ss << "Sub-attribute \"multires\" inside \"perlin\" must be a boolean.";
+                throw std::runtime_error(ss.str());
+            }
+            params.PerlinMultires = j["perlin"]["multires"];
+        }
     }
-    params.PerlinWeight = j["perlin"]["weight"];
-    params.PerlinScale = j["perlin"]["scale"];
-    params.PerlinOctaves = j["perlin"]["octaves"];
 
 
     // Voronoi settings
-    if (!j.contains("voronoi"))
-    {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "File must contains attribute \"voronoi\".";
-        throw std::runtime_error(ss.str());
-    }
-    if (!j["voronoi"].is_object())
-    {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "Attribute \"voronoi\" must be an object.";
-        throw std::runtime_error(ss.str());
-    }
-    if (!j["voronoi"].contains("weight"))
-    {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "Attribute \"voronoi\" must contain sub-attribute \"weight\".";
-        throw std::runtime_error(ss.str());
-    }
-    if (!j["voronoi"]["weight"].is_number_float())
-    {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "Sub-attribute \"weight\" inside \"voronoi\" must be a float.";
-        throw std::runtime_error(ss.str());
-    }
-    if (!j["voronoi"].contains("scale"))
+    params.VoronoiWeight = 0.0f;
+    params.VoronoiScale = 0.0f;
+    if (!HasGraph || j.contains("voronoi"))
     {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "Attribute \"voronoi\" must contain sub-attribute \"scale\".";
-        throw std::runtime_error(ss.str());
-    }
-    if (!j["voronoi"]["scale"].is_number_float())
-    {
-        std::stringstream ss;
-        ss << "JSON parse error on file " << filename << std::endl;
-        ss << "Sub-attribute \"scale\" inside \"voronoi\" must be a float.";
-        throw std::runtime_error(ss.str());
+        if (!j.contains("voronoi"))
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "File must contains attribute \"voronoi\".";
+            throw std::runtime_error(ss.str());
+        }
+        if (!j["voronoi"].is_object())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Attribute \"voronoi\" must be an object.";
+            throw std::runtime_error(ss.str());
+        }
+        if (!j["voronoi"].contains("weight"))
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Attribute \"voronoi\" must contain sub-attribute \"weight\".";
+            throw std::runtime_error(ss.str());
+        }
+        if (!j["voronoi"]["weight"].is_number_float())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"weight\" inside \"voronoi\" must be a float.";
+            throw std::runtime_error(ss.str());
+        }
+        if (!j["voronoi"].contains("scale"))
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Attribute \"voronoi\" must contain sub-attribute \"scale\".";
+            throw std::runtime_error(ss.str());
+        }
+        if (!j["voronoi"]["scale"].is_number_float())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"scale\" inside \"voronoi\" must be a float.";
+            throw std::runtime_error(ss.str());
+        }
+        params.VoronoiWeight = j["voronoi"]["weight"];
+        params.VoronoiScale = j["voronoi"]["scale"];
     }
-    params.VoronoiWeight = j["voronoi"]["weight"];
-    params.VoronoiScale = j["voronoi"]["scale"];
 
 
     // River settings
@@ -273,6 +308,148 @@ RiverParams parse_river_params(const std::string& filename)
     params.RiverNodes = j["river"]["nodes"];
     params.RiverSamples = j["river"]["samples"];
     params.RiverSeed = j["river"]["seed"];
+    params.RiverSampler = NodeSampler::Uniform;
+    if (j["river"].contains("sampler"))
+    {
+        if (!j["river"]["sampler"].is_string())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"sampler\" inside \"river\" must be a string.";
+            throw std::runtime_error(ss.str());
+        }
+        params.RiverSampler = parse_node_sampler(j["river"]["sampler"]);
+    }
+    params.RiverMinDistance = 0.0f;
+    if (j["river"].contains("min_distance"))
+    {
+        if (!j["river"]["min_distance"].is_number())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"min_distance\" inside \"river\" must be a number.";
+            throw std::runtime_error(ss.str());
+        }
+        // Nodes closer than a pixel are indistinguishable, and their number grows
+        // with the inverse square of the distance
+        float MinPixel = 1.0f / std::max(1, std::max(params.Width, params.Height));
+        params.RiverMinDistance = j["river"]["min_distance"];
+        if (params.RiverMinDistance < MinPixel)
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"min_distance\" inside \"river\" must be at least the size of a pixel, " << MinPixel << '.';
+            throw std::runtime_error(ss.str());
+        }
+    }
+    params.RiverRng = NodeRng::MT19937;
+    if (j["river"].contains("rng"))
+    {
+        if (!j["river"]["rng"].is_string())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"rng\" inside \"river\" must be a string.";
+            throw std::runtime_error(ss.str());
+        }
+        params.RiverRng = parse_node_rng(j["river"]["rng"]);
+    }
+    params.RiverParallelDelaunay = false;
+    if (j["river"].contains("delaunay"))
+    {
+        if (j["river"]["delaunay"] != "serial" && j["river"]["delaunay"] != "parallel")
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"delaunay\" inside \"river\" must be either \"serial\" or \"parallel\".";
+            throw std::runtime_error(ss.str());
+        }
+        params.RiverParallelDelaunay = j["river"]["delaunay"] == "parallel";
+    }
+    params.RiverGraph = ProximityGraph::Delaunay;
+    if (j["river"].contains("graph"))
+    {
+        if (!j["river"]["graph"].is_string())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"graph\" inside \"river\" must be a string.";
+            throw std::runtime_error(ss.str());
+        }
+        params.RiverGraph = parse_proximity_graph(j["river"]["graph"]);
+    }
+    params.RiverNeighbours = 8;
+    if (j["river"].contains("neighbours"))
+    {
+        if (!j["river"]["neighbours"].is_number_integer() || j["river"]["neighbours"] < 1)
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"neighbours\" inside \"river\" must be a positive integer.";
+            throw std::runtime_error(ss.str());
+        }
+        params.RiverNeighbours = j["river"]["neighbours"];
+    }
+    params.RiverSpline = SplineType::Natural;
+    if (j["river"].contains("spline"))
+    {
+        if (!j["river"]["spline"].is_string())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"spline\" inside \"river\" must be a string.";
+            throw std::runtime_error(ss.str());
+        }
+        params.RiverSpline = parse_spline_type(j["river"]["spline"]);
+    }
+    params.RiverTributaries = 0;
+    if (j["river"].contains("tributaries"))
+    {
+        if (!j["river"]["tributaries"].is_number_integer() || j["river"]["tributaries"] < 0)
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"tributaries\" inside \"river\" must be a non-negative integer.";
+            throw std::runtime_error(ss.str());
+        }
+        params.RiverTributaries = j["river"]["tributaries"];
+    }
+    params.RiverHeightCost = 0.0f;
+    if (j["river"].contains("height_cost"))
+    {
+        if (!j["river"]["height_cost"].is_number() || j["river"]["height_cost"] < 0.0f)
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"height_cost\" inside \"river\" must be a non-negative number.";
+            throw std::runtime_error(ss.str());
+        }
+        params.RiverHeightCost = j["river"]["height_cost"];
+    }
+    params.RiverSlopeCost = 0.0f;
+    if (j["river"].contains("slope_cost"))
+    {
+        if (!j["river"]["slope_cost"].is_number() || j["river"]["slope_cost"] < 0.0f)
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"slope_cost\" inside \"river\" must be a non-negative number.";
+            throw std::runtime_error(ss.str());
+        }
+        params.RiverSlopeCost = j["river"]["slope_cost"];
+    }
+    params.RiverNarrowBand = true;
+    if (j["river"].contains("narrow_band"))
+    {
+        if (!j["river"]["narrow_band"].is_boolean())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"narrow_band\" inside \"river\" must be a boolean.";
+            throw std::runtime_error(ss.str());
+        }
+        params.RiverNarrowBand = j["river"]["narrow_band"];
+    }
 
 
     // Blur settings
@@ -397,28 +574,312 @@ RiverParams parse_river_params(const std::string& filename)
     params.PlaneDelta = j["plane"]["delta"];
     params.PlaneWidth = j["plane"]["width"];
     params.PlaneHeight = j["plane"]["height"];
+    params.PlaneFilter = ResampleFilter::Bilinear;
+    if (j["plane"].contains("filter"))
+    {
+        if (!j["plane"]["filter"].is_string())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Sub-attribute \"filter\" inside \"plane\" must be a string.";
+            throw std::runtime_error(ss.str());
+        }
+        params.PlaneFilter = parse_resample_filter(j["plane"]["filter"]);
+    }
 
 
 
     // Output filenames
-    if (!j.contains("output_file"))
+    params.OutHMap = "";
+    params.OutMesh = "";
+    if (!j.contains("output_file") && RequireOutput)
     {
         std::stringstream ss;
         ss << "JSON parse error on file " << filename << std::endl;
         ss << "File must contains attribute \"output_file\".";
         throw std::runtime_error(ss.str());
     }
-    if (!j["output_file"].is_string())
+    if (j.contains("output_file") && !j["output_file"].is_string())
     {
         std::stringstream ss;
         ss << "JSON parse error on file " << filename << std::endl;
         ss << "Attribute \"output_file\" must be a string.";
         throw std::runtime_error(ss.str());
     }
-    params.OutHMap = j["output_file"];
-    std::transform(params.OutHMap.begin(), params.OutHMap.end(), params.OutHMap.begin(), my_tolower);
-    params.OutMesh = std::filesystem::path(params.OutHMap).replace_extension(".obj").string();
+    if (j.contains("output_file"))
+    {
+        params.OutHMap = j["output_file"];
+        std::transform(params.OutHMap.begin(), params.OutHMap.end(), params.OutHMap.begin(), my_tolower);
+        params.OutMesh = std::filesystem::path(params.OutHMap).replace_extension(".obj").string();
+    }
+    params.OutBitDepth = 8;
+    if (j.contains("bit_depth"))
+    {
+        if (!j["bit_depth"].is_number_integer() || (j["bit_depth"] != 8 && j["bit_depth"] != 16))
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Attribute \"bit_depth\" must be either 8 or 16.";
+            throw std::runtime_error(ss.str());
+        }
+        params.OutBitDepth = j["bit_depth"];
+    }
+
+    // PNG encoder settings
+    if (j.contains("png"))
+    {
+        if (!j["png"].is_object())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Attribute \"png\" must be an object.";
+            throw std::runtime_error(ss.str());
+        }
+        if (j["png"].contains("level"))
+        {
+            if (!j["png"]["level"].is_number_integer() || j["png"]["level"] < 0 || j["png"]["level"] > 9)
+            {
+                std::stringstream ss;
+                ss << "JSON parse error on file " << filename << std::endl;
+                ss << "Sub-attribute \"level\" inside \"png\" must be an integer between 0 and 9.";
+                throw std::runtime_error(ss.str());
+            }
+            params.Png.Level = j["png"]["level"];
+        }
+        if (j["png"].contains("filter"))
+        {
+            if (!j["png"]["filter"].is_string())
+            {
+                std::stringstream ss;
+                ss << "JSON parse error on file " << filename << std::endl;
+                ss << "Sub-attribute \"filter\" inside \"png\" must be a string.";
+                throw std::runtime_error(ss.str());
+            }
+            params.Png.Filter = parse_png_filter(j["png"]["filter"]);
+        }
+        if (j["png"].contains("threads"))
+        {
+            if (!j["png"]["threads"].is_number_integer())
+            {
+                std::stringstream ss;
+                ss << "JSON parse error on file " << filename << std::endl;
+                ss << "Sub-attribute \"threads\" inside \"png\" must be an integer.";
+                throw std::runtime_error(ss.str());
+            }
+            params.Png.Threads = j["png"]["threads"];
+        }
+    }
+
+    // Optional profiling trace
+    params.OutTrace = "";
+    if (j.contains("trace"))
+    {
+        if (!j["trace"].is_string())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Attribute \"trace\" must be a string.";
+            throw std::runtime_error(ss.str());
+        }
+        params.OutTrace = j["trace"];
+    }
+
+    // Optional cache of intermediate results
+    params.CacheDir = "";
+    if (j.contains("cache_dir"))
+    {
+        if (!j["cache_dir"].is_string())
+        {
+            std::stringstream ss;
+            ss << "JSON parse error on file " << filename << std::endl;
+            ss << "Attribute \"cache_dir\" must be a string.";
+            throw std::runtime_error(ss.str());
+        }
+        params.CacheDir = j["cache_dir"];
+    }
 
 
     return params;
+}
+
+namespace
+{
+
+// Nodes are resolved by name, and the inputs of a node are added to the graph
+// before the node itself, so that the graph is in topological order
+class NoiseGraphParser
+{
+private:
+    const nlohmann::json& m_Nodes;
+    const std::string& m_Filename;
+    std::map<std::string, int> m_Index;
+    std::set<std::string> m_Open;
+
+    [[noreturn]] void Fail(const std::string& Message) const
+    {
+        std::stringstream ss;
+        ss << "JSON parse error on file " << m_Filename << std::endl;
+        ss << Message;
+        throw std::runtime_error(ss.str());
+    }
+
+    bool Has(const nlohmann::json& J, const std::string& Name, const std::string& Key, bool Required) const
+    {
+        if (J.contains(Key))
+            return true;
+        if (Required)
+            Fail("Node \"" + Name + "\" inside \"noise_graph\" must contain sub-attribute \"" + Key + "\".");
+        return false;
+    }
+
+    void Number(const nlohmann::json& J, const std::string& Name, const std::string& Key, float& Out,
+                bool Required = false) const
+    {
+        if (!Has(J, Name, Key, Required))
+            return;
+        if (!J[Key].is_number())
+            Fail("Sub-attribute \"" + Key + "\" of node \"" + Name + "\" inside \"noise_graph\" must be a number.");
+        Out = J[Key];
+    }
+
+    void Integer(const nlohmann::json& J, const std::string& Name, const std::string& Key, int& Out,
+                 bool Required = false) const
+    {
+        if (!Has(J, Name, Key, Required))
+            return;
+        if (!J[Key].is_number_integer())
+            Fail("Sub-attribute \"" + Key + "\" of node \"" + Name + "\" inside \"noise_graph\" must be an integer.");
+        Out = J[Key];
+    }
+
+    // Inputs are node names or numbers, which become constant nodes
+    int Input(const nlohmann::json& In, const std::string& Name)
+    {
+        if (In.is_string())
+            return Resolve(In);
+        if (!In.is_number())
+            Fail("The inputs of node \"" + Name + "\" inside \"noise_graph\" must be node names or numbers.");
+        NoiseNode C;
+        C.Op = NoiseOp::Const;
+        C.Value = In;
+        return Graph.Add(C);
+    }
+
+public:
+    NoiseGraph Graph;
+
+    NoiseGraphParser(const nlohmann::json& Nodes, const std::string& Filename)
+        : m_Nodes(Nodes), m_Filename(Filename) { }
+
+    int Resolve(const std::string& Name)
+    {
+        auto Found = m_Index.find(Name);
+        if (Found != m_Index.end())
+            return Found->second;
+        if (!m_Nodes.contains(Name))
+            Fail("Node \"" + Name + "\" is not defined inside \"noise_graph\".");
+        if (m_Open.count(Name) > 0)
+            Fail("The nodes inside \"noise_graph\" form a cycle through \"" + Name + "\".");
+        const nlohmann::json& J = m_Nodes[Name];
+        if (!J.is_object() || !J.contains("type") || !J["type"].is_string())
+            Fail("Node \"" + Name + "\" inside \"noise_graph\" must be an object with a string \"type\".");
+        m_Open.insert(Name);
+
+        NoiseNode N;
+        N.Op = parse_noise_op(J["type"]);
+        int Node = -1;
+        switch (N.Op)
+        {
+        case NoiseOp::Const:
+            Number(J, Name, "value", N.Value, true);
+            break;
+        case NoiseOp::FBM:
+        case NoiseOp::Ridged:
+            Number(J, Name, "scale", N.Scale, true);
+            Integer(J, Name, "octaves", N.Octaves, true);
+            Number(J, Name, "lacunarity", N.Lacunarity);
+            Number(J, Name, "gain", N.Gain);
+            if (N.Op == NoiseOp::Ridged)
+                Number(J, Name, "offset", N.Offset);
+            Integer(J, Name, "seed", N.Seed);
+            break;
+        case NoiseOp::Cellular:
+            Number(J, Name, "scale", N.Scale, true);
+            Integer(J, Name, "seed", N.Seed);
+            break;
+        case NoiseOp::Spectral:
+            Number(J, Name, "beta", N.Beta, true);
+            Number(J, Name, "scale", N.Scale);
+            Integer(J, Name, "seed", N.Seed);
+            break;
+        case NoiseOp::Warp:
+            Has(J, Name, "input", true);
+            N.A = Input(J["input"], Name);
+            Number(J, Name, "amount", N.Amount, true);
+            Number(J, Name, "scale", N.Scale, true);
+            Integer(J, Name, "octaves", N.Octaves);
+            Integer(J, Name, "seed", N.Seed);
+            break;
+        case NoiseOp::Clamp:
+            Has(J, Name, "input", true);
+            N.A = Input(J["input"], Name);
+            Number(J, Name, "min", N.Min, true);
+            Number(J, Name, "max", N.Max, true);
+            if (N.Min > N.Max)
+                Fail("The \"min\" of node \"" + Name + "\" inside \"noise_graph\" cannot exceed its \"max\".");
+            break;
+        case NoiseOp::Add:
+        case NoiseOp::Mul:
+        {
+            // More than two inputs are combined from left to right
+            Has(J, Name, "inputs", true);
+            if (!J["inputs"].is_array() || J["inputs"].size() < 2)
+                Fail("Sub-attribute \"inputs\" of node \"" + Name + "\" inside \"noise_graph\" must be an array of at least two inputs.");
+            Node = Input(J["inputs"][0], Name);
+            for (size_t k = 1; k < J["inputs"].size(); ++k)
+            {
+                N.A = Node;
+                N.B = Input(J["inputs"][k], Name);
+                Node = Graph.Add(N);
+            }
+            break;
+        }
+        }
+        if (N.Octaves < 1)
+            Fail("Sub-attribute \"octaves\" of node \"" + Name + "\" inside \"noise_graph\" must be a positive integer.");
+        if (Node < 0)
+            Node = Graph.Add(N);
+
+        m_Open.erase(Name);
+        m_Index[Name] = Node;
+        return Node;
+    }
+};
+
+} // namespace
+
+
+NoiseGraph parse_noise_graph(const nlohmann::json& j, const std::string& filename)
+{
+    if (!j.is_object() || !j.contains("nodes") || !j["nodes"].is_object())
+    {
+        std::stringstream ss;
+        ss << "JSON parse error on file " << filename << std::endl;
+        ss << "Attribute \"noise_graph\" must be an object with an object \"nodes\".";
+        throw std::runtime_error(ss.str());
+    }
+    if (!j.contains("output") || !j["output"].is_string())
+    {
+        std::stringstream ss;
+        ss << "JSON parse error on file " << filename << std::endl;
+        ss << "Attribute \"noise_graph\" must contain a string \"output\".";
+        throw std::runtime_error(ss.str());
+    }
+
+    // Every node is checked, even if it does not reach the output
+    NoiseGraphParser Parser(j["nodes"], filename);
+    for (const auto& Node : j["nodes"].items())
+        Parser.Resolve(Node.key());
+    Parser.Graph.SetOutput(Parser.Resolve(j["output"]));
+    return Parser.Graph;
 }
\ No newline at end of file
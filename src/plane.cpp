@@ -10,44 +10,37 @@
  * @date        2023-09-05
  */
 #include <plane.hpp>
+#include <profiler.hpp>
 #include <fstream>
 #include <sstream>
 #include <cmath>
+#include <algorithm>
 
-void triangulate_plane(const HeightMap& HM, int w, int h, int& ntris, float** verts, unsigned int** tris)
+void triangulate_plane(const HeightMap& HM, int w, int h, int& ntris, float** verts, unsigned int** tris, ResampleFilter filter)
 {
+    RT_PROFILE_SCOPE("triangulate_plane");
     int nverts = w * h;
     ntris = (w - 1) * (h - 1) * 2;
 
     *verts = (float*)std::malloc(3 * nverts * sizeof(float));
     *tris = (unsigned int*)std::malloc(3 * ntris * sizeof(unsigned int));
 
+    // Resample the heights into the last third of the vertex buffer, then
+    // spread them in place: vertex k is written to [3k, 3k + 2], which never
+    // overlaps the heights of the vertices after k still to be read
+    float* z = *verts + 2 * nverts;
+    resample(HM, z, w, h, filter);
     for (int j = 0; j < h; ++j)
     {
-        float v = j / (float)h;
-        float jj = v * HM.GetHeight();
-        int j0 = std::floor(jj);
-        int j1 = std::ceil(jj);
-        jj -= j0;
+        float v = j / (float)std::max(h - 1, 1);
         for (int i = 0; i < w; ++i)
         {
-            float u = i / (float)w;
-            float ii = u * HM.GetWidth();
-            int i0 = std::floor(ii);
-            int i1 = std::ceil(ii);
-            ii -= i0;
-
-            float z00 = HM(i0, j0);
-            float z01 = HM(i0, j1);
-            float z10 = HM(i1, j0);
-            float z11 = HM(i1, j1);
-            float z0 = z01 * ii + z00 * (1 - ii);
-            float z1 = z11 * ii + z10 * (1 - ii);
-            float z = z1 * jj + z0 * (1 - jj);
-
-            (*verts)[3 * (j * w + i)] = u;
-            (*verts)[3 * (j * w + i) + 1] = v;
-            (*verts)[3 * (j * w + i) + 2] = z;
+            float u = i / (float)std::max(w - 1, 1);
+            int k = j * w + i;
+            float zk = z[k];
+            (*verts)[3 * k] = u;
+            (*verts)[3 * k + 1] = v;
+            (*verts)[3 * k + 2] = zk;
         }
     }
 
@@ -74,6 +67,7 @@ void triangulate_plane(const HeightMap& HM, int w, int h, int& ntris, float** ve
 
 void export_plane_as_obj(const std::string& filename, int nverts, int ntris, float* verts, unsigned int* tris)
 {
+    RT_PROFILE_SCOPE("export_obj");
     std::ofstream of;
     of.open(filename, std::ios::out);
     if (!of.is_open())
@@ -92,5 +86,6 @@ void export_plane_as_obj(const std::string& filename, int nverts, int ntris, flo
         of << "f " << tris[3 * i] + 1 << ' ' << tris[3 * i + 1] + 1 << ' ' << tris[3 * i + 2] + 1 << '\n';
 
 
+    RT_PROFILE_COUNT("bytes_written", (int64_t)of.tellp());
     of.close();
 }
\ No newline at end of file
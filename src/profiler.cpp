@@ -0,0 +1,186 @@
+/**
+ * @file        profiler.cpp
+ *
+ * @brief       Implements Profiler.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <profiler.hpp>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+
+namespace
+{
+
+struct ProfileEvent
+{
+    const char* Name;
+    int Thread;
+    uint64_t Begin;
+    uint64_t End;
+};
+
+struct ProfileData
+{
+    std::mutex Lock;
+    std::vector<ProfileEvent> Events;
+    std::map<std::string, int64_t> Counters;
+    std::chrono::steady_clock::time_point Epoch = std::chrono::steady_clock::now();
+    std::atomic<int> NextThread { 0 };
+};
+
+ProfileData& data()
+{
+    static ProfileData Data;
+    return Data;
+}
+
+// Small sequential thread ids read better in trace viewers than native ids
+int thread_index()
+{
+    thread_local int Index = data().NextThread++;
+    return Index;
+}
+
+} // namespace
+
+
+std::atomic<bool> Profiler::s_Enabled { false };
+
+void Profiler::Enable(bool On)
+{
+    data();
+    s_Enabled.store(On);
+}
+
+void Profiler::Reset()
+{
+    ProfileData& D = data();
+    std::lock_guard<std::mutex> Guard(D.Lock);
+    D.Events.clear();
+    D.Counters.clear();
+}
+
+uint64_t Profiler::Now()
+{
+    auto dt = std::chrono::steady_clock::now() - data().Epoch;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count();
+}
+
+void Profiler::Record(const char* Name, uint64_t Begin, uint64_t End)
+{
+    ProfileData& D = data();
+    int Thread = thread_index();
+    std::lock_guard<std::mutex> Guard(D.Lock);
+    D.Events.push_back({ Name, Thread, Begin, End });
+}
+
+void Profiler::AddCounter(const char* Name, int64_t Value)
+{
+    ProfileData& D = data();
+    std::lock_guard<std::mutex> Guard(D.Lock);
+    D.Counters[Name] += Value;
+}
+
+
+void Profiler::PrintSummary(std::ostream& os)
+{
+    struct Stats
+    {
+        uint64_t First;
+        int Calls = 0;
+        double Total = 0.0;
+        double Max = 0.0;
+    };
+
+    ProfileData& D = data();
+    std::lock_guard<std::mutex> Guard(D.Lock);
+
+    // Stages are listed in order of first appearance
+    std::map<std::string, Stats> ByName;
+    for (const auto& E : D.Events)
+    {
+        auto it = ByName.find(E.Name);
+        if (it == ByName.end())
+            it = ByName.emplace(E.Name, Stats{ E.Begin }).first;
+        double ms = (E.End - E.Begin) * 1e-6;
+        it->second.First = std::min(it->second.First, E.Begin);
+        it->second.Calls++;
+        it->second.Total += ms;
+        it->second.Max = std::max(it->second.Max, ms);
+    }
+    std::vector<std::pair<std::string, Stats>> Rows(ByName.begin(), ByName.end());
+    std::sort(Rows.begin(), Rows.end(), [](const auto& a, const auto& b) { return a.second.First < b.second.First; });
+
+    os << std::left << std::setw(28) << "Stage"
+       << std::right << std::setw(8) << "Calls"
+       << std::setw(14) << "Total (ms)"
+       << std::setw(14) << "Mean (ms)"
+       << std::setw(14) << "Max (ms)" << '\n';
+    os << std::fixed << std::setprecision(3);
+    for (const auto& R : Rows)
+    {
+        os << std::left << std::setw(28) << R.first
+           << std::right << std::setw(8) << R.second.Calls
+           << std::setw(14) << R.second.Total
+           << std::setw(14) << R.second.Total / R.second.Calls
+           << std::setw(14) << R.second.Max << '\n';
+    }
+
+    if (!D.Counters.empty())
+    {
+        os << '\n' << std::left << std::setw(36) << "Counter" << std::right << std::setw(20) << "Value" << '\n';
+        for (const auto& C : D.Counters)
+            os << std::left << std::setw(36) << C.first << std::right << std::setw(20) << C.second << '\n';
+    }
+    os << std::defaultfloat;
+}
+
+
+void Profiler::WriteTrace(const std::string& filename)
+{
+    ProfileData& D = data();
+    nlohmann::json Trace;
+    nlohmann::json& Events = Trace["traceEvents"];
+    Events = nlohmann::json::array();
+    uint64_t Last = 0;
+    {
+        std::lock_guard<std::mutex> Guard(D.Lock);
+        for (const auto& E : D.Events)
+        {
+            Events.push_back({ { "name", E.Name }, { "ph", "X" }, { "pid", 1 }, { "tid", E.Thread },
+                               { "ts", E.Begin * 1e-3 }, { "dur", (E.End - E.Begin) * 1e-3 } });
+            Last = std::max(Last, E.End);
+        }
+        // Counters are totals, so they are reported once at the end of the trace
+        for (const auto& C : D.Counters)
+        {
+            Events.push_back({ { "name", C.first }, { "ph", "C" }, { "pid", 1 },
+                               { "ts", Last * 1e-3 }, { "args", { { "value", C.second } } } });
+        }
+    }
+    Trace["displayTimeUnit"] = "ms";
+
+    std::ofstream of;
+    of.open(filename, std::ios::out);
+    if (!of.is_open())
+    {
+        std::stringstream ss;
+        ss << "Cannot open file " << filename << " for writing.";
+        throw std::runtime_error(ss.str());
+    }
+    of << Trace.dump();
+    of.close();
+}
\ No newline at end of file
@@ -0,0 +1,308 @@
+/**
+ * @file        proximity.cpp
+ *
+ * @brief       Implements the sparse proximity graphs the river can be routed on.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <geometry.hpp>
+#include <profiler.hpp>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+
+ProximityGraph parse_proximity_graph(const std::string& name)
+{
+    if (name == "delaunay")
+        return ProximityGraph::Delaunay;
+    if (name == "gabriel")
+        return ProximityGraph::Gabriel;
+    if (name == "rng")
+        return ProximityGraph::RNG;
+    if (name == "knn")
+        return ProximityGraph::KNN;
+
+    std::stringstream ss;
+    ss << "Unknown proximity graph \"" << name << "\".";
+    throw std::runtime_error(ss.str());
+}
+
+
+namespace
+{
+
+// Sorted adjacency lists of the edges E, in compressed rows
+void adjacency(int nPts, const std::vector<std::pair<int, int>>& E, std::vector<int>& Idxs, std::vector<int>& Adj)
+{
+    Idxs.assign(nPts + 1, 0);
+    for (const auto& e : E)
+    {
+        Idxs[e.first + 1]++;
+        Idxs[e.second + 1]++;
+    }
+    for (int v = 0; v < nPts; ++v)
+        Idxs[v + 1] += Idxs[v];
+    Adj.resize(Idxs[nPts]);
+    std::vector<int> Fill(Idxs.begin(), Idxs.end() - 1);
+    for (const auto& e : E)
+    {
+        Adj[Fill[e.first]++] = e.second;
+        Adj[Fill[e.second]++] = e.first;
+    }
+    for (int v = 0; v < nPts; ++v)
+        std::sort(Adj.begin() + Idxs[v], Adj.begin() + Idxs[v + 1]);
+}
+
+double dist2(const sf::Vector2f& a, const sf::Vector2f& b)
+{
+    double dx = (double)a.x - b.x;
+    double dy = (double)a.y - b.y;
+    return dx * dx + dy * dy;
+}
+
+} // namespace
+
+
+// The apexes of the two Delaunay triangles of ab are common neighbours of a
+// and b, and if any point lies in the circle of diameter ab, so does one of them
+std::vector<std::pair<int, int>> gabriel_graph(const std::vector<sf::Vector2f>& P, const std::vector<std::pair<int, int>>& E)
+{
+    RT_PROFILE_SCOPE("gabriel_graph");
+    std::vector<int> Idxs;
+    std::vector<int> Adj;
+    adjacency(P.size(), E, Idxs, Adj);
+
+    std::vector<std::pair<int, int>> Kept;
+    std::vector<int> Common;
+    for (const auto& e : E)
+    {
+        sf::Vector2f a = P[e.first];
+        sf::Vector2f b = P[e.second];
+        Common.clear();
+        std::set_intersection(Adj.begin() + Idxs[e.first], Adj.begin() + Idxs[e.first + 1],
+                              Adj.begin() + Idxs[e.second], Adj.begin() + Idxs[e.second + 1],
+                              std::back_inserter(Common));
+        // c is strictly inside the circle iff the angle acb is obtuse
+        bool Empty = true;
+        for (int c : Common)
+        {
+            sf::Vector2f q = P[c];
+            if (((double)a.x - q.x) * ((double)b.x - q.x) + ((double)a.y - q.y) * ((double)b.y - q.y) < 0.0)
+            {
+                Empty = false;
+                break;
+            }
+        }
+        if (Empty)
+            Kept.push_back(e);
+    }
+    RT_PROFILE_COUNT("gabriel_graph.edges", (int64_t)Kept.size());
+    return Kept;
+}
+
+
+// A point in the lune of ab is closer to a than b is. From any point, some
+// Delaunay neighbour is closer to a (greedy routing always succeeds on Delaunay
+// triangulations), so all the points of the disc of radius |ab| around a can be
+// reached from a without leaving it. The lune is usually tested empty or not on
+// the first neighbours of a, but long edges may visit many points.
+std::vector<std::pair<int, int>> relative_neighbourhood_graph(const std::vector<sf::Vector2f>& P,
+                                                              const std::vector<std::pair<int, int>>& E)
+{
+    RT_PROFILE_SCOPE("relative_neighbourhood_graph");
+    std::vector<int> Idxs;
+    std::vector<int> Adj;
+    adjacency(P.size(), E, Idxs, Adj);
+
+    std::vector<std::pair<int, int>> Kept;
+    std::vector<int> Seen(P.size(), -1);
+    std::vector<int> Stack;
+    int64_t Visits = 0;
+    for (size_t k = 0; k < E.size(); ++k)
+    {
+        int a = E[k].first;
+        int b = E[k].second;
+        double ab = dist2(P[a], P[b]);
+        bool Empty = true;
+        Stack.assign(1, a);
+        Seen[a] = Seen[b] = (int)k;
+        while (!Stack.empty() && Empty)
+        {
+            int v = Stack.back();
+            Stack.pop_back();
+            for (int s = Idxs[v]; s < Idxs[v + 1]; ++s)
+            {
+                int c = Adj[s];
+                if (Seen[c] == (int)k)
+                    continue;
+                Seen[c] = (int)k;
+                Visits++;
+                if (dist2(P[a], P[c]) >= ab)
+                    continue;
+                if (dist2(P[b], P[c]) < ab)
+                {
+                    Empty = false;
+                    break;
+                }
+                Stack.push_back(c);
+            }
+        }
+        if (Empty)
+            Kept.push_back(E[k]);
+    }
+    RT_PROFILE_COUNT("relative_neighbourhood_graph.visits", Visits);
+    RT_PROFILE_COUNT("relative_neighbourhood_graph.edges", (int64_t)Kept.size());
+    return Kept;
+}
+
+
+std::vector<std::pair<int, int>> knn_graph(const std::vector<sf::Vector2f>& P, int k, ThreadPool* Pool)
+{
+    RT_PROFILE_SCOPE("knn_graph");
+    if (k < 1)
+    {
+        std::stringstream ss;
+        ss << "Points must be joined to at least one neighbour, not " << k << '.';
+        throw std::runtime_error(ss.str());
+    }
+    int nPts = P.size();
+    std::vector<std::pair<int, int>> E;
+    if (nPts < 2)
+        return E;
+    k = std::min(k, nPts - 1);
+
+    // Grid over the bounding box of the points, with about two points per cell
+    sf::Vector2f Min = P[0];
+    sf::Vector2f Max = P[0];
+    for (const auto& p : P)
+    {
+        Min.x = std::min(Min.x, p.x);
+        Min.y = std::min(Min.y, p.y);
+        Max.x = std::max(Max.x, p.x);
+        Max.y = std::max(Max.y, p.y);
+    }
+    int n = std::max(1, (int)std::sqrt(nPts / 2.0));
+    float cw = std::max((Max.x - Min.x) / n, 1e-12f);
+    float ch = std::max((Max.y - Min.y) / n, 1e-12f);
+    auto CellX = [&](float x) { return std::min(n - 1, (int)((x - Min.x) / cw)); };
+    auto CellY = [&](float y) { return std::min(n - 1, (int)((y - Min.y) / ch)); };
+
+    std::vector<int> Start((size_t)n * n + 1, 0);
+    std::vector<int> Cell(nPts);
+    for (int i = 0; i < nPts; ++i)
+    {
+        Cell[i] = CellY(P[i].y) * n + CellX(P[i].x);
+        Start[Cell[i] + 1]++;
+    }
+    for (size_t c = 0; c < (size_t)n * n; ++c)
+        Start[c + 1] += Start[c];
+    // Points are stored in cell order, so that the points of a cell are contiguous
+    std::vector<int> Sorted(nPts);
+    std::vector<int> Fill(Start.begin(), Start.end() - 1);
+    for (int i = 0; i < nPts; ++i)
+        Sorted[Fill[Cell[i]]++] = i;
+    std::vector<sf::Vector2f> Q(nPts);
+    for (int s = 0; s < nPts; ++s)
+        Q[s] = P[Sorted[s]];
+
+    // The cells of ring r + 1 around a point are at least r cells away from it, so
+    // the search stops once the k-th neighbour is closer than that. Queries also run
+    // in cell order, so that consecutive ones visit the same cells.
+    std::vector<int> Nearest((size_t)nPts * k);
+    float Side = std::min(cw, ch);
+    auto Search = [&](size_t Begin, size_t End)
+    {
+        std::vector<std::pair<double, int>> Best(k);
+        for (int s = (int)Begin; s < (int)End; ++s)
+        {
+            sf::Vector2f p = Q[s];
+            int ci = CellX(p.x);
+            int cj = CellY(p.y);
+            int nBest = 0;
+            // Best is sorted by distance, and only its first k entries are kept
+            auto Visit = [&](int x, int y)
+            {
+                int c = y * n + x;
+                for (int t = Start[c]; t < Start[c + 1]; ++t)
+                {
+                    if (t == s)
+                        continue;
+                    double d = dist2(p, Q[t]);
+                    if (nBest == k && d >= Best[k - 1].first)
+                        continue;
+                    int m = nBest < k ? nBest++ : k - 1;
+                    for (; m > 0 && Best[m - 1].first > d; --m)
+                        Best[m] = Best[m - 1];
+                    Best[m] = { d, t };
+                }
+            };
+            for (int r = 0; r < n; ++r)
+            {
+                for (int y = std::max(0, cj - r); y <= std::min(n - 1, cj + r); ++y)
+                {
+                    if (y == cj - r || y == cj + r)
+                    {
+                        for (int x = std::max(0, ci - r); x <= std::min(n - 1, ci + r); ++x)
+                            Visit(x, y);
+                    }
+                    else
+                    {
+                        if (ci - r >= 0)
+                            Visit(ci - r, y);
+                        if (ci + r < n)
+                            Visit(ci + r, y);
+                    }
+                }
+                double Reach = (double)r * Side;
+                if (nBest == k && Best[k - 1].first <= Reach * Reach)
+                    break;
+            }
+            int i = Sorted[s];
+            for (int m = 0; m < k; ++m)
+                Nearest[(size_t)i * k + m] = Sorted[Best[m].second];
+        }
+    };
+
+    parallel_for(Pool, nPts, 1 << 14, Search);
+
+    // A point is joined to its neighbours and to the points it is a neighbour of.
+    // Edges are bucketed by their lower end, and repetitions are dropped per row.
+    std::vector<int> Idxs(nPts + 1, 0);
+    for (int i = 0; i < nPts; ++i)
+    {
+        for (int m = 0; m < k; ++m)
+            Idxs[std::min(i, Nearest[(size_t)i * k + m]) + 1]++;
+    }
+    for (int i = 0; i < nPts; ++i)
+        Idxs[i + 1] += Idxs[i];
+    std::vector<int> Upper(Idxs[nPts]);
+    std::vector<int> Row(Idxs.begin(), Idxs.end() - 1);
+    for (int i = 0; i < nPts; ++i)
+    {
+        for (int m = 0; m < k; ++m)
+        {
+            int j = Nearest[(size_t)i * k + m];
+            Upper[Row[std::min(i, j)]++] = std::max(i, j);
+        }
+    }
+    E.reserve(Upper.size());
+    for (int i = 0; i < nPts; ++i)
+    {
+        auto Begin = Upper.begin() + Idxs[i];
+        auto End = Upper.begin() + Idxs[i + 1];
+        std::sort(Begin, End);
+        for (auto it = Begin; it != End; ++it)
+        {
+            if (it == Begin || *it != *(it - 1))
+                E.emplace_back(i, *it);
+        }
+    }
+    RT_PROFILE_COUNT("knn_graph.edges", (int64_t)E.size());
+    return E;
+}
\ No newline at end of file
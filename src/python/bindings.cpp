@@ -0,0 +1,145 @@
+/**
+ * @file        bindings.cpp
+ *
+ * @brief       Python bindings of RTLib.
+ *
+ * @details     Heightmaps are exposed through the buffer protocol, so that
+ *              numpy.asarray() views their data without copies. Mesh buffers are
+ *              returned as NumPy arrays that take ownership of them. Every
+ *              function releases the GIL while it runs, so that maps can be built
+ *              concurrently from Python threads.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <geometry.hpp>
+#include <noises.hpp>
+#include <plane.hpp>
+#include <parser.hpp>
+#include <rtlib.hpp>
+#include <mutex>
+#include <cstdlib>
+
+namespace py = pybind11;
+
+
+namespace
+{
+
+// A generator must not run on two threads at once, and the GIL is released
+struct PyGenerator
+{
+    RiverGenerator Gen;
+    std::mutex Lock;
+};
+
+// NumPy array over a buffer allocated with malloc(), which it frees
+template<typename T>
+py::array_t<T> owned_array(T* Data, py::ssize_t Rows, py::ssize_t Cols)
+{
+    py::capsule Owner(Data, [](void* p) { std::free(p); });
+    return py::array_t<T>({ Rows, Cols }, Data, Owner);
+}
+
+} // namespace
+
+
+PYBIND11_MODULE(rivergen, m)
+{
+    m.doc() = "River terrain generator.";
+
+    py::class_<HeightMap>(m, "HeightMap", py::buffer_protocol())
+        .def(py::init<int, int>(), py::arg("width"), py::arg("height"))
+        .def_property_readonly("width", &HeightMap::GetWidth)
+        .def_property_readonly("height", &HeightMap::GetHeight)
+        .def_property_readonly("min", &HeightMap::GetMin)
+        .def_property_readonly("max", &HeightMap::GetMax)
+        .def_buffer([](HeightMap& HM) -> py::buffer_info
+        {
+            // Row-major, indexed as [y, x]
+            return py::buffer_info(HM.RawData(), sizeof(float), py::format_descriptor<float>::format(), 2,
+                                   { (py::ssize_t)HM.GetHeight(), (py::ssize_t)HM.GetWidth() },
+                                   { (py::ssize_t)(sizeof(float) * HM.GetWidth()), (py::ssize_t)sizeof(float) });
+        });
+
+    m.def("river",
+          [](int w, int h, int nodes, int samples, float thickness, int ksx, int ksy, float sigma, int seed)
+          {
+              return river(w, h, nodes, samples, thickness, ksx, ksy, sigma, seed);
+          },
+          py::arg("width"), py::arg("height"), py::arg("nodes"), py::arg("samples"), py::arg("thickness"),
+          py::arg("ksx"), py::arg("ksy"), py::arg("sigma"), py::arg("seed") = 0,
+          py::call_guard<py::gil_scoped_release>(),
+          "Draw and blur the bed of a river into a new heightmap.");
+
+    m.def("add_perlin", &add_perlin,
+          py::arg("hmap"), py::arg("alpha"), py::arg("scale"), py::arg("octaves"), py::arg("multires") = false,
+          py::call_guard<py::gil_scoped_release>(),
+          "Add alpha times fractal Perlin noise to hmap, in place.");
+
+    m.def("add_voronoi", &add_voronoi,
+          py::arg("hmap"), py::arg("alpha"), py::arg("scale"),
+          py::call_guard<py::gil_scoped_release>(),
+          "Add alpha times Voronoi noise to hmap, in place.");
+
+    m.def("add_spectral", &add_spectral,
+          py::arg("hmap"), py::arg("alpha"), py::arg("beta"), py::arg("seed") = 0,
+          py::call_guard<py::gil_scoped_release>(),
+          "Add alpha times tileable 1/f^beta noise to hmap, in place.");
+
+    m.def("add_noise_graph",
+          [](HeightMap& HM, const std::string& Graph, float alpha)
+          {
+              NoiseGraph G = parse_noise_graph(nlohmann::json::parse(Graph), "<graph>");
+              py::gil_scoped_release Release;
+              G.Evaluate(HM, alpha);
+          },
+          py::arg("hmap"), py::arg("graph"), py::arg("alpha") = 1.0f,
+          "Add alpha times the output of a noise graph, given as a JSON string in the format of "
+          "\"noise_graph\" in the configuration files, to hmap, in place.");
+
+    m.def("gauss_blur",
+          [](HeightMap& HM, int ksx, int ksy, float sigma) { gauss_blur(HM, ksx, ksy, sigma); },
+          py::arg("hmap"), py::arg("ksx"), py::arg("ksy"), py::arg("sigma"),
+          py::call_guard<py::gil_scoped_release>(),
+          "Separable gaussian blur of hmap, in place.");
+
+    m.def("triangulate_plane",
+          [](const HeightMap& HM, int w, int h, const std::string& Filter)
+          {
+              ResampleFilter F = parse_resample_filter(Filter);
+              int ntris;
+              float* verts;
+              unsigned int* tris;
+              {
+                  py::gil_scoped_release Release;
+                  triangulate_plane(HM, w, h, ntris, &verts, &tris, F);
+              }
+              return py::make_tuple(owned_array(verts, (py::ssize_t)w * h, 3), owned_array(tris, ntris, 3));
+          },
+          py::arg("hmap"), py::arg("width"), py::arg("height"), py::arg("filter") = "bilinear",
+          "Triangulate a width-by-height grid over hmap. Returns the vertices and the triangles.");
+
+    py::class_<PyGenerator>(m, "Generator")
+        .def(py::init<>())
+        .def("generate",
+             [](PyGenerator& G, const std::string& Config)
+             {
+                 RiverParams Params = parse_river_params(nlohmann::json::parse(Config), "<config>", false);
+                 HeightMap HM(Params.Width, Params.Height);
+                 {
+                     py::gil_scoped_release Release;
+                     std::lock_guard<std::mutex> Guard(G.Lock);
+                     G.Gen.Generate(Params, HM);
+                 }
+                 return HM;
+             },
+             py::arg("config"),
+             "Generate the terrain described by a JSON configuration string, in the format of the "
+             "configuration files. The generator keeps its buffers between calls.");
+}
\ No newline at end of file
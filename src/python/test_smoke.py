@@ -0,0 +1,47 @@
+"""
+Smoke test of the rivergen module: import it and run one generation.
+
+Run by ctest when configured with -DRT_BUILD_PYTHON=ON, with the module on PYTHONPATH.
+"""
+import json
+import math
+import sys
+
+import rivergen
+
+
+CONFIG = {
+    "size": 256,
+    "perlin": {"weight": 0.8, "scale": 5.0, "octaves": 4},
+    "voronoi": {"weight": 0.4, "scale": 6.0},
+    "gauss": {"ksx": 15, "ksy": 0, "sigma": 4.0},
+    "river": {"nodes": 30, "samples": 10, "thickness": 20.0, "seed": 0},
+    "plane": {"delta": 3.0, "width": 64, "height": 64},
+}
+
+
+def main():
+    hm = rivergen.Generator().generate(json.dumps(CONFIG))
+    if hm.width != 256 or hm.height != 256:
+        print("Unexpected size %dx%d." % (hm.width, hm.height))
+        return 1
+
+    # The buffer protocol is checked through memoryview, so that the test does not need NumPy
+    view = memoryview(hm)
+    if view.format != "f" or view.shape != (256, 256):
+        print("Unexpected buffer of format %s with shape %s." % (view.format, view.shape))
+        return 1
+    heights = view.cast("B").cast("f")
+    if not all(math.isfinite(x) for x in heights):
+        print("The generated map contains non-finite heights.")
+        return 1
+    if min(heights) == max(heights):
+        print("The generated map is flat.")
+        return 1
+
+    print("rivergen smoke test passed.")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
\ No newline at end of file
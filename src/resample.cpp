@@ -0,0 +1,215 @@
+/**
+ * @file        resample.cpp
+ *
+ * @brief       Implements separable resampling.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <resample.hpp>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RT_RESAMPLE_SSE
+#endif
+
+
+ResampleFilter parse_resample_filter(const std::string& name)
+{
+    if (name == "bilinear")
+        return ResampleFilter::Bilinear;
+    if (name == "bicubic")
+        return ResampleFilter::Bicubic;
+    if (name == "lanczos" || name == "lanczos3")
+        return ResampleFilter::Lanczos3;
+
+    std::stringstream ss;
+    ss << "Unknown resampling filter \"" << name << "\".";
+    throw std::runtime_error(ss.str());
+}
+
+
+namespace
+{
+
+int filter_taps(ResampleFilter Filter)
+{
+    switch (Filter)
+    {
+    case ResampleFilter::Bicubic:   return 4;
+    case ResampleFilter::Lanczos3:  return 6;
+    default:                        return 2;
+    }
+}
+
+float sinc(float x)
+{
+    if (x == 0.0f)
+        return 1.0f;
+    x *= 3.14159265358979f;
+    return std::sin(x) / x;
+}
+
+float filter_weight(ResampleFilter Filter, float x)
+{
+    x = std::abs(x);
+    switch (Filter)
+    {
+    case ResampleFilter::Bicubic:
+        // Catmull-Rom (a = -0.5)
+        if (x < 1.0f)
+            return (1.5f * x - 2.5f) * x * x + 1.0f;
+        if (x < 2.0f)
+            return ((-0.5f * x + 2.5f) * x - 4.0f) * x + 2.0f;
+        return 0.0f;
+    case ResampleFilter::Lanczos3:
+        return x < 3.0f ? sinc(x) * sinc(x / 3.0f) : 0.0f;
+    default:
+        return std::max(0.0f, 1.0f - x);
+    }
+}
+
+
+/**
+ * Tap indices and weights for every output sample along one axis. Taps of the
+ * output sample i are stored at [i * Taps, (i + 1) * Taps).
+ */
+struct AxisTaps
+{
+    int Taps;
+    std::vector<int> Idx;
+    std::vector<float> W;
+
+    AxisTaps(ResampleFilter Filter, int SrcN, int DstN)
+    {
+        // When shrinking, the kernel is stretched over the source samples that
+        // fall between two outputs, so that it also filters out what the output
+        // grid cannot represent
+        float step = DstN > 1 ? (SrcN - 1) / (float)(DstN - 1) : 0.0f;
+        float scale = std::max(1.0f, step);
+        int Support = filter_taps(Filter);
+        Taps = scale > 1.0f ? (int)std::ceil(Support * scale) : Support;
+        Idx.resize(DstN * Taps);
+        W.resize(DstN * Taps);
+
+        float Radius = Support / 2 * scale;
+        for (int i = 0; i < DstN; ++i)
+        {
+            float x = i * step;
+            int base = (int)std::floor(x - Radius) + 1;
+            float sum = 0.0f;
+            for (int k = 0; k < Taps; ++k)
+            {
+                int s = base + k;
+                float w = filter_weight(Filter, (x - s) / scale);
+                Idx[i * Taps + k] = std::min(SrcN - 1, std::max(0, s));
+                W[i * Taps + k] = w;
+                sum += w;
+            }
+            // Lanczos does not form a partition of unity
+            for (int k = 0; k < Taps; ++k)
+                W[i * Taps + k] /= sum;
+        }
+    }
+};
+
+
+// Out[x] = W * In[x] (Accumulate == false) or Out[x] += W * In[x]
+void row_axpy(float* Out, const float* In, float W, int n, bool Accumulate)
+{
+    int x = 0;
+#ifdef RT_RESAMPLE_SSE
+    __m128 w4 = _mm_set1_ps(W);
+    if (Accumulate)
+    {
+        for (; x + 4 <= n; x += 4)
+            _mm_storeu_ps(Out + x, _mm_add_ps(_mm_loadu_ps(Out + x), _mm_mul_ps(w4, _mm_loadu_ps(In + x))));
+    }
+    else
+    {
+        for (; x + 4 <= n; x += 4)
+            _mm_storeu_ps(Out + x, _mm_mul_ps(w4, _mm_loadu_ps(In + x)));
+    }
+#endif
+    if (Accumulate)
+    {
+        for (; x < n; ++x)
+            Out[x] += W * In[x];
+    }
+    else
+    {
+        for (; x < n; ++x)
+            Out[x] = W * In[x];
+    }
+}
+
+} // namespace
+
+
+void resample(const float* Src, int SrcW, int SrcH,
+              float* Dst, int DstW, int DstH,
+              ResampleFilter Filter)
+{
+    if (SrcW <= 0 || SrcH <= 0 || DstW <= 0 || DstH <= 0)
+        throw std::runtime_error("Cannot resample an empty grid.");
+
+    AxisTaps Cols(Filter, SrcW, DstW);
+    AxisTaps Rows(Filter, SrcH, DstH);
+    int Tx = Cols.Taps;
+    int Ty = Rows.Taps;
+
+    // Vertically filtered source row, reused while consecutive output rows
+    // share the same taps (i.e., when upsampling)
+    std::vector<float> Line(SrcW);
+    const int* LastIdx = nullptr;
+    const float* LastW = nullptr;
+
+    for (int j = 0; j < DstH; ++j)
+    {
+        const int* ry = Rows.Idx.data() + j * Ty;
+        const float* wy = Rows.W.data() + j * Ty;
+        bool Same = LastIdx != nullptr &&
+                    std::memcmp(LastIdx, ry, Ty * sizeof(int)) == 0 &&
+                    std::memcmp(LastW, wy, Ty * sizeof(float)) == 0;
+        if (!Same)
+        {
+            bool Acc = false;
+            for (int k = 0; k < Ty; ++k)
+            {
+                if (wy[k] == 0.0f)
+                    continue;
+                row_axpy(Line.data(), Src + (size_t)ry[k] * SrcW, wy[k], SrcW, Acc);
+                Acc = true;
+            }
+            if (!Acc)
+                std::fill(Line.begin(), Line.end(), 0.0f);
+            LastIdx = ry;
+            LastW = wy;
+        }
+
+        float* Out = Dst + (size_t)j * DstW;
+        const int* rx = Cols.Idx.data();
+        const float* wx = Cols.W.data();
+        for (int i = 0; i < DstW; ++i, rx += Tx, wx += Tx)
+        {
+            float z = 0.0f;
+            for (int k = 0; k < Tx; ++k)
+                z += wx[k] * Line[rx[k]];
+            Out[i] = z;
+        }
+    }
+}
+
+void resample(const HeightMap& HM, float* Dst, int DstW, int DstH, ResampleFilter Filter)
+{
+    resample(HM.RawData(), HM.GetWidth(), HM.GetHeight(), Dst, DstW, DstH, Filter);
+}
\ No newline at end of file
@@ -10,75 +10,471 @@
  * @date        2023-09-05
  */
 #include <geometry.hpp>
+#include <profiler.hpp>
 #include <graph.hpp>
 #include <spline.hpp>
-#include <sfLine.hpp>
+#include <sfStroke.hpp>
+#include <SFML/OpenGL.hpp>
 #include <sstream>
 #include <random>
+#include <cmath>
+#include <algorithm>
+
+
+namespace
+{
+
+// Below this size the whole search fits in cache anyway
+VertexOrder graph_order(int nPts)
+{
+    const int RenumberFrom = 1 << 16;
+    return nPts >= RenumberFrom ? VertexOrder::Hilbert : VertexOrder::Input;
+}
+
+Graph river_graph(const std::vector<sf::Vector2f>& P, const std::vector<std::pair<int, int>>& E,
+                  const std::vector<float>& Costs)
+{
+    if (Costs.empty())
+        return Graph(P, E, graph_order(P.size()));
+    return Graph(P, E, Costs, graph_order(P.size()));
+}
+
+// Sparse graphs can leave the source and the target in different components
+void check_reachable(float Length)
+{
+    if (std::isinf(Length))
+        throw std::runtime_error("The source of the river cannot reach the target along the edges of the graph.");
+}
+
+struct BandPiece
+{
+    int Row;
+    int Begin;
+    int End;
+};
+
+// Columns that the strokes of the polylines, in pixels, can cover in each row,
+// grown by mx columns and my rows. A segment and the discs at its ends lie
+// within its largest radius of it, plus a pixel for the rasterization, so a row
+// only sees the points of the segment within that reach of it.
+RowSpans stroke_band(const std::vector<std::vector<sf::Vector2f>>& Polylines,
+                     const std::vector<std::vector<float>>& Thickness, int w, int h, int mx, int my)
+{
+    std::vector<BandPiece> Pieces;
+    auto AddSegment = [&](const sf::Vector2f& p0, const sf::Vector2f& p1, float r)
+    {
+        float rx = r + 1.0f + mx;
+        float ry = r + 1.0f + my;
+        int j0 = std::max(0, (int)std::floor(std::min(p0.y, p1.y) - ry));
+        int j1 = std::min(h - 1, (int)std::floor(std::max(p0.y, p1.y) + ry));
+        sf::Vector2f d = p1 - p0;
+        for (int j = j0; j <= j1; ++j)
+        {
+            float t0 = 0.0f;
+            float t1 = 1.0f;
+            if (std::abs(d.y) > 1e-6f)
+            {
+                float ta = (j - ry - p0.y) / d.y;
+                float tb = (j + 1 + ry - p0.y) / d.y;
+                t0 = std::max(t0, std::min(ta, tb));
+                t1 = std::min(t1, std::max(ta, tb));
+                if (t0 > t1)
+                    continue;
+            }
+            float xa = p0.x + t0 * d.x;
+            float xb = p0.x + t1 * d.x;
+            int Begin = std::max(0, (int)std::floor(std::min(xa, xb) - rx));
+            int End = std::min(w, (int)std::ceil(std::max(xa, xb) + rx) + 1);
+            if (Begin < End)
+                Pieces.push_back({ j, Begin, End });
+        }
+    };
+    for (size_t b = 0; b < Polylines.size(); ++b)
+    {
+        const auto& Line = Polylines[b];
+        if (Line.size() == 1)
+            AddSegment(Line[0], Line[0], Thickness[b][0] / 2);
+        for (size_t i = 0; i + 1 < Line.size(); ++i)
+            AddSegment(Line[i], Line[i + 1], std::max(Thickness[b][i], Thickness[b][i + 1]) / 2);
+    }
+
+    // Pieces are bucketed by row, then sorted and merged within each row
+    RowSpans Band;
+    Band.Rows.assign(h + 1, 0);
+    for (const auto& p : Pieces)
+        Band.Rows[p.Row + 1]++;
+    for (int j = 0; j < h; ++j)
+        Band.Rows[j + 1] += Band.Rows[j];
+    std::vector<std::pair<int, int>> Sorted(Pieces.size());
+    std::vector<int> Fill(Band.Rows.begin(), Band.Rows.end() - 1);
+    for (const auto& p : Pieces)
+        Sorted[Fill[p.Row]++] = { p.Begin, p.End };
+    Band.Spans.reserve(Sorted.size());
+    std::vector<int> Merged(h + 1, 0);
+    for (int j = 0; j < h; ++j)
+    {
+        auto First = Sorted.begin() + Band.Rows[j];
+        auto Last = Sorted.begin() + Band.Rows[j + 1];
+        std::sort(First, Last);
+        for (auto it = First; it != Last; ++it)
+        {
+            if (it != First && it->first <= Band.Spans.back().second)
+                Band.Spans.back().second = std::max(Band.Spans.back().second, it->second);
+            else
+                Band.Spans.push_back(*it);
+        }
+        Merged[j + 1] = Band.Spans.size();
+    }
+    Band.Rows = std::move(Merged);
+    return Band;
+}
+
+// Count samples of the curve through Nodes, at t = i / Div. Catmull-Rom curves
+// are local, so they are sampled a segment at a time, without a Spline over all
+// the nodes; the samples are the same as those of the Spline.
+std::vector<sf::Vector2f> sample_curve(const std::vector<sf::Vector2f>& Nodes, SplineType Type, int Count, int Div)
+{
+    std::vector<sf::Vector2f> Out(Count);
+    if (Type != SplineType::CatmullRom)
+    {
+        Spline S(Nodes, Type);
+        for (int i = 0; i < Count; ++i)
+            Out[i] = S(i / (float)Div);
+        return Out;
+    }
+
+    int m = Nodes.size();
+    int i = 0;
+    for (int k = 0; k + 1 < m && i < Count; ++k)
+    {
+        // The points beyond the ends are mirrored, as in Spline
+        const sf::Vector2f& P1 = Nodes[k];
+        const sf::Vector2f& P2 = Nodes[k + 1];
+        sf::Vector2f P0 = k > 0 ? Nodes[k - 1] : 2.0f * P1 - P2;
+        sf::Vector2f P3 = k + 2 < m ? Nodes[k + 2] : 2.0f * P2 - P1;
+        for (; i < Count; ++i)
+        {
+            float x = i / (float)Div * (m - 1);
+            if (k + 2 < m && x >= k + 1)
+                break;
+            Out[i] = Spline::Segment(P0, P1, P2, P3, x - k);
+        }
+    }
+    return Out;
+}
+
+} // namespace
 
 
 HeightMap river(int w, int h, int nodes, int samples, float thickness, int ksx, int ksy, float sigma, int seed)
 {
+    HeightMap hmap(w, h);
+    river(hmap, nodes, samples, thickness, ksx, ksy, sigma, seed);
+    return hmap;
+}
+
+
+void river(HeightMap& hmap, int nodes, int samples, float thickness, int ksx, int ksy, float sigma, int seed,
+           sf::RenderTexture* Canvas, float* Scratch)
+{
+    RT_PROFILE_SCOPE("river");
+    auto P = river_points(nodes, seed);
+    auto DE = delaunay(P);
+    std::vector<std::pair<int, int>> E(DE.begin(), DE.end());
+    auto Path = river_path(P, E);
+    auto Polyline = river_polyline(P, Path, nodes);
+    river_bed(hmap, Polyline, thickness, ksx, ksy, sigma, Canvas, Scratch);
+}
+
+
+std::vector<sf::Vector2f> river_points(int nodes, int seed, NodeSampler Sampler, float MinDistance, NodeRng Rng,
+                                       ThreadPool* Pool)
+{
+    // The square is always filled, as a capped sampling would only cover part of it
+    if (Sampler == NodeSampler::Poisson && MinDistance <= 0.0f)
+        MinDistance = poisson_disk_distance(nodes);
+
+    std::vector<sf::Vector2f> P;
+    if (Rng == NodeRng::Philox)
+    {
+        // Nodes, endpoints and Poisson candidates use distinct domains of the seed
+        uint64_t Key = (uint32_t)seed;
+        if (Sampler == NodeSampler::Poisson)
+        {
+            Philox4x32 Eng(Key, 2);
+            P = poisson_disk(MinDistance, poisson_disk_capacity(MinDistance), Eng);
+        }
+        else
+        {
+            P.reserve(nodes + 2);
+            P.resize(nodes);
+            philox_points(Key, 0, nodes, P.data(), Pool);
+        }
+        P.emplace_back(philox_point(Key, 0, 1).x, -0.1f);
+        P.emplace_back(philox_point(Key, 1, 1).x, 1.1f);
+        return P;
+    }
+
     std::mt19937 Eng(seed);
     std::uniform_real_distribution<float> Dist(0.0f, 1.0f);
 
     // Randomly sample the plane
-    std::vector<sf::Vector2f> P;
-    P.reserve(nodes + 2);
-    for (int i = 0; i < nodes; ++i)
-        P.emplace_back(Dist(Eng), Dist(Eng));
+    if (Sampler == NodeSampler::Poisson)
+        P = poisson_disk(MinDistance, poisson_disk_capacity(MinDistance), Eng);
+    else
+    {
+        P.reserve(nodes + 2);
+        for (int i = 0; i < nodes; ++i)
+            P.emplace_back(Dist(Eng), Dist(Eng));
+    }
     P.emplace_back(Dist(Eng), -0.1f);
     P.emplace_back(Dist(Eng), 1.1f);
+    return P;
+}
+
+
+std::vector<int> river_path(const std::vector<sf::Vector2f>& P, const std::vector<std::pair<int, int>>& E,
+                            const std::vector<float>& Costs)
+{
+    int nPts = P.size();
+    Graph G = river_graph(P, E, Costs);
+    Path Pth = G.ShortestPath(nPts - 2, nPts - 1);
+    check_reachable(Pth.Length);
+    return Pth.Nodes;
+}
+
 
+std::vector<std::vector<int>> river_network(const std::vector<sf::Vector2f>& P, const std::vector<std::pair<int, int>>& E,
+                                            int Tributaries, int seed, const std::vector<float>& Costs)
+{
+    RT_PROFILE_SCOPE("river_network");
+    int nPts = P.size();
+    Graph G = river_graph(P, E, Costs);
+    PathTree T = G.ShortestPathTree(nPts - 1);
+    check_reachable(T.Dist[nPts - 2]);
+
+    // The target is the outlet of the whole network
+    std::vector<std::vector<int>> Branches;
+    std::vector<char> OnNetwork(nPts, 0);
+    OnNetwork[nPts - 1] = 1;
+    Branches.push_back(T.PathToRoot(nPts - 2).Nodes);
+    for (int v : Branches[0])
+        OnNetwork[v] = 1;
+
+    // Tributaries spring from random nodes and flow down the tree until they join the network
+    std::mt19937 Eng(seed);
+    std::uniform_int_distribution<int> Dist(0, nPts - 3);
+    for (int k = 0; k < Tributaries; ++k)
+    {
+        int v = Dist(Eng);
+        if (OnNetwork[v] || T.Next[v] < 0)
+            continue;
+        std::vector<int> Branch;
+        for (; !OnNetwork[v]; v = T.Next[v])
+        {
+            Branch.push_back(v);
+            OnNetwork[v] = 1;
+        }
+        Branch.push_back(v);
+        Branches.push_back(std::move(Branch));
+    }
+    RT_PROFILE_COUNT("river_network.branches", (int64_t)Branches.size());
+    return Branches;
+}
+
+
+void river_network_polylines(const std::vector<sf::Vector2f>& P, const std::vector<std::vector<int>>& Branches, int nodes,
+                             std::vector<std::vector<sf::Vector2f>>& Polylines, std::vector<std::vector<float>>& Widths,
+                             SplineType Type)
+{
+    Polylines.clear();
+    Widths.clear();
+    if (Branches.empty())
+        return;
+
+    // Every branch ends on a previous one, so going backwards the channels
+    // upstream of a node are complete before the node is propagated
+    std::vector<float> Up(P.size(), 0.0f);
+    for (int b = (int)Branches.size() - 1; b >= 0; --b)
+    {
+        const auto& B = Branches[b];
+        for (int i = 0; i + 1 < (int)B.size(); ++i)
+            Up[B[i + 1]] += Up[B[i]] + (P[B[i + 1]] - P[B[i]]).length();
+    }
+    float UpMax = *std::max_element(Up.begin(), Up.end());
+
+    // Springs are still drawn, if thinner
+    const float MinWidth = 0.2f;
+    auto Width = [UpMax, MinWidth](float u) { return UpMax > 0.0f ? std::max(MinWidth, std::sqrt(u / UpMax)) : 1.0f; };
+    int StemSize = std::max<int>(2, Branches[0].size());
+    for (const auto& B : Branches)
+    {
+        int m = B.size();
+        if (m < 2)
+            continue;
+        std::vector<sf::Vector2f> Nodes;
+        std::vector<float> NodeWidths;
+        Nodes.reserve(m);
+        NodeWidths.reserve(m);
+        for (int v : B)
+        {
+            Nodes.push_back(P[v]);
+            NodeWidths.push_back(Width(Up[v]));
+        }
+        // A tributary keeps its own width up to the junction
+        if (&B != &Branches[0])
+            NodeWidths[m - 1] = Width(Up[B[m - 2]] + (P[B[m - 1]] - P[B[m - 2]]).length());
+
+        // Nodes are evenly spaced in the parameter of the spline, which ends on the last one
+        int n = std::max(2, (int)((int64_t)nodes * m / StemSize));
+        std::vector<sf::Vector2f> Polyline = sample_curve(Nodes, Type, n - 1, n - 1);
+        Polyline.push_back(Nodes.back());
+        std::vector<float> W(n);
+        for (int i = 0; i < n; ++i)
+        {
+            float t = i / (float)(n - 1);
+            float x = t * (m - 1);
+            int k = std::min(m - 2, (int)x);
+            W[i] = NodeWidths[k] + (x - k) * (NodeWidths[k + 1] - NodeWidths[k]);
+        }
+        Polylines.push_back(std::move(Polyline));
+        Widths.push_back(std::move(W));
+    }
+}
+
+
+std::vector<sf::Vector2f> river_polyline(const std::vector<sf::Vector2f>& P, const std::vector<int>& Path, int nodes,
+                                         SplineType Type)
+{
     // Compute the river's spline
-    auto E = delaunay(P);
-    Graph G(P, E);
-    auto Path = G.ShortestPath(nodes, nodes + 1);
     std::vector<sf::Vector2f> Nodes;
-    Nodes.reserve(Path.Nodes.size());
-    for (int i = 0; i < Path.Nodes.size(); ++i)
-        Nodes.push_back(P[Path.Nodes[i]]);
-    Spline S(Nodes);
+    Nodes.reserve(Path.size());
+    for (int i = 0; i < Path.size(); ++i)
+        Nodes.push_back(P[Path[i]]);
+    return sample_curve(Nodes, Type, nodes, nodes);
+}
+
+
+void river_bed(HeightMap& hmap, const std::vector<sf::Vector2f>& Polyline, float thickness, int ksx, int ksy, float sigma,
+               sf::RenderTexture* Canvas, float* Scratch, bool NarrowBand)
+{
+    river_bed(hmap, { Polyline }, { std::vector<float>(Polyline.size(), thickness) }, ksx, ksy, sigma, Canvas, Scratch,
+              NarrowBand);
+}
+
+
+void river_bed(HeightMap& hmap, const std::vector<std::vector<sf::Vector2f>>& Polylines,
+               const std::vector<std::vector<float>>& Thickness, int ksx, int ksy, float sigma,
+               sf::RenderTexture* Canvas, float* Scratch, bool NarrowBand)
+{
+    int w = hmap.GetWidth();
+    int h = hmap.GetHeight();
 
     // Create the render target
-    sf::RenderTexture renderTexture;
+    sf::RenderTexture LocalCanvas;
+    sf::RenderTexture& renderTexture = Canvas != nullptr ? *Canvas : LocalCanvas;
     sf::Vector2u ImgSize(w, h);
-    if (!renderTexture.create(ImgSize))
+    if (renderTexture.getSize() != ImgSize && !renderTexture.create(ImgSize))
     {
         std::stringstream ss;
         ss << "Cannot create a " << w << "-by-" << h << " render texture.";
         throw std::runtime_error(ss.str());
     }
-    renderTexture.clear();
-    sf::Color c1, c2;
-    c1 = sf::Color(255, 255, 255, 255);
-    sf::RenderStates states;
-    states.blendMode = sf::BlendMode(sf::BlendMode::SrcAlpha, sf::BlendMode::OneMinusSrcAlpha);
-    for (int i = 0; i < nodes - 1; ++i)
-    {
-        float t0 = i / (float)nodes;
-        float t1 = (i + 1) / (float)nodes;
-        sf::Vector2f p0 = S(t0);
-        sf::Vector2f p1 = S(t1);
-        p0.x *= w;
-        p0.y *= h;
-        p1.x *= w;
-        p1.y *= h;
-        sf::CircleShape circle(thickness / 2);
-        circle.setPosition(p1 - sf::Vector2f(thickness / 2, thickness / 2));
-        circle.setFillColor(c1);
-        renderTexture.draw(circle);
-        sfLine line(p0, p1, thickness);
-        renderTexture.draw(line, states);
+
+    std::vector<std::vector<sf::Vector2f>> Pixels(Polylines);
+    for (auto& Line : Pixels)
+    {
+        for (auto& p : Line)
+        {
+            p.x *= w;
+            p.y *= h;
+        }
+    }
+    {
+        RT_PROFILE_SCOPE("draw");
+        renderTexture.clear();
+        // The whole river is one stroke, so that it is drawn in a single call
+        sfStroke Stroke;
+        for (size_t b = 0; b < Pixels.size(); ++b)
+            Stroke.Add(Pixels[b], Thickness[b]);
+        RT_PROFILE_COUNT("draw.vertices", (int64_t)Stroke.GetVertexCount());
+        sf::RenderStates states;
+        states.blendMode = sf::BlendMode(sf::BlendMode::SrcAlpha, sf::BlendMode::OneMinusSrcAlpha);
+        renderTexture.draw(Stroke, states);
+        renderTexture.display();
     }
-    renderTexture.display();
 
-    // Transfer to heightmap and blur
-    auto tex = renderTexture.getTexture();
-    auto img = tex.copyToImage();
-    HeightMap hmap(img);
-    gauss_blur(hmap, ksx, ksy, sigma);
+    if (!NarrowBand)
+    {
+        // Transfer to heightmap and blur
+        {
+            RT_PROFILE_SCOPE("readback");
+            const sf::Texture& tex = renderTexture.getTexture();
+            auto img = tex.copyToImage();
+            for (int j = 0; j < h; ++j)
+            {
+                for (int i = 0; i < w; ++i)
+                    hmap.Set(i, j, img.getPixel({ i, j }).r / 255.0f);
+            }
+        }
+        gauss_blur(hmap, ksx, ksy, sigma, Scratch);
+        return;
+    }
 
+    // The bed is zero away from the river, so only the band that the blur can
+    // reach from the stroke is transferred and blurred
+    RowSpans Band;
+    {
+        RT_PROFILE_SCOPE("band");
+        Band = stroke_band(Pixels, Thickness, w, h, ksx, ksy);
+    }
+    {
+        RT_PROFILE_SCOPE("readback");
+        // Only the bounding box of the band is read back, straight from the
+        // render target, which stores its rows bottom-up
+        int i0 = w, i1 = 0, j0 = h, j1 = 0;
+        for (int j = 0; j < h; ++j)
+        {
+            if (Band.Rows[j] == Band.Rows[j + 1])
+                continue;
+            j0 = std::min(j0, j);
+            j1 = j + 1;
+            i0 = std::min(i0, Band.Spans[Band.Rows[j]].first);
+            i1 = std::max(i1, Band.Spans[Band.Rows[j + 1] - 1].second);
+        }
+        std::vector<std::uint8_t> Box;
+        if (j0 < j1)
+        {
+            Box.resize((size_t)(i1 - i0) * (j1 - j0) * 4);
+            if (!renderTexture.setActive(true))
+                throw std::runtime_error("Cannot activate the render texture of the river.");
+            glReadPixels(i0, h - j1, i1 - i0, j1 - j0, GL_RGBA, GL_UNSIGNED_BYTE, Box.data());
+            renderTexture.setActive(false);
+        }
+        RT_PROFILE_COUNT("readback.pixels", (int64_t)Box.size() / 4);
 
-    return hmap;
+        // Every pixel is written once, with zero outside the spans
+        float* Dst = hmap.RawData();
+        float Max = 0.0f;
+        for (int j = 0; j < h; ++j)
+        {
+            float* Row = Dst + (size_t)j * w;
+            const std::uint8_t* Src = nullptr;
+            if (Band.Rows[j] < Band.Rows[j + 1])
+                Src = Box.data() + (size_t)(j1 - 1 - j) * (i1 - i0) * 4;
+            int i = 0;
+            for (int s = Band.Rows[j]; s < Band.Rows[j + 1]; ++s)
+            {
+                std::fill(Row + i, Row + Band.Spans[s].first, 0.0f);
+                for (i = Band.Spans[s].first; i < Band.Spans[s].second; ++i)
+                {
+                    Row[i] = Src[4 * (i - i0)] / 255.0f;
+                    Max = std::max(Max, Row[i]);
+                }
+            }
+            std::fill(Row + i, Row + w, 0.0f);
+        }
+        hmap.SetRange(std::min(hmap.GetMin(), 0.0f), std::max(hmap.GetMax(), Max));
+    }
+    gauss_blur(hmap, Band, ksx, ksy, sigma, Scratch);
 }
\ No newline at end of file
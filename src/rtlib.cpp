@@ -0,0 +1,563 @@
+/**
+ * @file        rtlib.cpp
+ *
+ * @brief       Implements the in-process generation API.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <rtlib.hpp>
+#include <rtlib.h>
+#include <geometry.hpp>
+#include <noises.hpp>
+#include <profiler.hpp>
+#include <tasks.hpp>
+#include <string>
+#include <new>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+namespace
+{
+
+bool uses_terrain_costs(const RiverParams& Params)
+{
+    return Params.RiverHeightCost > 0.0f || Params.RiverSlopeCost > 0.0f;
+}
+
+// A noise graph takes the place of the Perlin layer, with unit weight, and
+// leaves the Voronoi layer empty
+void noise_weights(const RiverParams& Params, float& VoronoiWeight, float& PerlinWeight)
+{
+    VoronoiWeight = Params.Noise.IsEmpty() ? Params.VoronoiWeight : 0.0f;
+    PerlinWeight = Params.Noise.IsEmpty() ? Params.PerlinWeight : 1.0f;
+}
+
+// Nodes are plain numbers without padding, so they are hashed as they are
+uint64_t noise_graph_key(const NoiseGraph& Graph, int w, int h)
+{
+    const std::vector<NoiseNode>& Nodes = Graph.GetNodes();
+    return StageKey("noise_graph").Add(w).Add(h).Add(Graph.GetOutput())
+                                  .Add(Nodes.data(), Nodes.size() * sizeof(NoiseNode)).Value();
+}
+
+} // namespace
+
+
+// The noise layers get their size on first use
+RiverGenerator::RiverGenerator(ThreadPool* Pool) : m_Voronoi(1, 1), m_Perlin(1, 1), m_Pool(Pool) { }
+RiverGenerator::~RiverGenerator() { }
+
+
+void RiverGenerator::Generate(const RiverParams& Params, HeightMap& HM)
+{
+    RT_PROFILE_SCOPE("generate");
+    int w = HM.GetWidth();
+    int h = HM.GetHeight();
+    // The bed is drawn over the previous contents of HM, but not over its range
+    HM.SetRange(0.0f, 0.0f);
+
+    // Cached or concurrent stages are composed from the layers, which gives the same map.
+    // The river can only follow the terrain if the noise layers come first.
+    if (!Params.CacheDir.empty() || m_Pool != nullptr || uses_terrain_costs(Params))
+    {
+        float vw, pw;
+        noise_weights(Params, vw, pw);
+        GenerateLayers(Params, HM, m_Voronoi, m_Perlin);
+        compose_layers(HM, m_Voronoi, m_Perlin, vw, pw, Params.PlaneDelta, HM);
+        return;
+    }
+
+    size_t ScratchSize = gauss_blur_scratch_size(w, h, Params.GaussKSX, Params.GaussKSY);
+    if (m_Scratch.size() < ScratchSize)
+        m_Scratch.resize(ScratchSize);
+
+    // Compute the river
+    GenerateBed(Params, HM, nullptr, nullptr, nullptr);
+
+    // Add noises
+    if (!Params.Noise.IsEmpty())
+        Params.Noise.Evaluate(HM);
+    else
+    {
+        add_voronoi(HM, Params.VoronoiWeight, Params.VoronoiScale);
+        add_perlin(HM, Params.PerlinWeight, Params.PerlinScale, Params.PerlinOctaves, Params.PerlinMultires);
+    }
+
+    // Invert and add delta height
+    RT_PROFILE_SCOPE("compose");
+    HM.Invert();
+    for (int j = 0; j < h; ++j)
+    {
+        float t = j / (float)(h - 1);
+        float d = Params.PlaneDelta * (1 - t);
+        for (int i = 0; i < w; ++i)
+            HM.Set(i, j, HM(i, j) + d);
+    }
+}
+
+void RiverGenerator::Generate(const RiverParams& Params, float* Out)
+{
+    HeightMap HM(Params.Width, Params.Height, Out);
+    Generate(Params, HM);
+}
+
+
+namespace
+{
+
+// Branches of a network are stored one after the other, and the first node of
+// each one is stored as -(v + 1)
+std::vector<int> pack_branches(const std::vector<std::vector<int>>& Branches)
+{
+    std::vector<int> Packed;
+    for (const auto& B : Branches)
+    {
+        for (size_t i = 0; i < B.size(); ++i)
+            Packed.push_back(i == 0 ? -(B[i] + 1) : B[i]);
+    }
+    return Packed;
+}
+
+std::vector<std::vector<int>> unpack_branches(const std::vector<int>& Packed)
+{
+    std::vector<std::vector<int>> Branches;
+    for (int v : Packed)
+    {
+        if (v < 0 || Branches.empty())
+            Branches.emplace_back();
+        Branches.back().push_back(v < 0 ? -v - 1 : v);
+    }
+    return Branches;
+}
+
+// Samples are stored as (x, y, width), and the first of each polyline has a negative width
+std::vector<sf::Vector3f> pack_polylines(const std::vector<std::vector<sf::Vector2f>>& Polylines,
+                                         const std::vector<std::vector<float>>& Widths)
+{
+    std::vector<sf::Vector3f> Packed;
+    for (size_t b = 0; b < Polylines.size(); ++b)
+    {
+        for (size_t i = 0; i < Polylines[b].size(); ++i)
+            Packed.emplace_back(Polylines[b][i].x, Polylines[b][i].y, i == 0 ? -Widths[b][i] : Widths[b][i]);
+    }
+    return Packed;
+}
+
+void unpack_polylines(const std::vector<sf::Vector3f>& Packed, std::vector<std::vector<sf::Vector2f>>& Polylines,
+                      std::vector<std::vector<float>>& Widths)
+{
+    Polylines.clear();
+    Widths.clear();
+    for (const auto& p : Packed)
+    {
+        if (p.z < 0.0f || Polylines.empty())
+        {
+            Polylines.emplace_back();
+            Widths.emplace_back();
+        }
+        Polylines.back().emplace_back(p.x, p.y);
+        Widths.back().push_back(std::abs(p.z));
+    }
+}
+
+// Heights of the terrain the noise layers produce once added to the bed and
+// inverted, normalized to [0, 1]
+HeightMap terrain_relief(const HeightMap& Voronoi, const HeightMap& Perlin, float vw, float pw)
+{
+    int w = Voronoi.GetWidth();
+    int h = Voronoi.GetHeight();
+    size_t n = (size_t)w * h;
+    HeightMap Relief(w, h);
+    const float* V = Voronoi.RawData();
+    const float* P = Perlin.RawData();
+    float* R = Relief.RawData();
+    float Min = std::numeric_limits<float>::infinity();
+    float Max = -Min;
+    for (size_t k = 0; k < n; ++k)
+    {
+        R[k] = -(vw * V[k] + pw * P[k]);
+        Min = std::min(Min, R[k]);
+        Max = std::max(Max, R[k]);
+    }
+    if (Max > Min)
+    {
+        Relief.SetRange(Min, Max);
+        Relief.Normalize();
+    }
+    else
+        std::fill(R, R + n, 0.0f);
+    return Relief;
+}
+
+} // namespace
+
+
+// Each key hashes the parameters of its stage and the key of the stage it
+// reads from, and stages are loaded lazily starting from the last one, so
+// that only the stages downstream of a changed parameter are recomputed.
+// Without a cache, the stages simply run in order.
+void RiverGenerator::GenerateBed(const RiverParams& Params, HeightMap& HM, const StageCache* Cache,
+                                 const HeightMap* Voronoi, const HeightMap* Perlin)
+{
+    RT_PROFILE_SCOPE("river");
+    int w = HM.GetWidth();
+    int h = HM.GetHeight();
+    // Fields that only some variants of a stage read are hashed for those only,
+    // so that changing an unused one keeps the cached stages
+    StageKey PointsKey("points");
+    PointsKey.Add(Params.RiverNodes).Add(Params.RiverSeed).Add((int)Params.RiverSampler).Add((int)Params.RiverRng);
+    if (Params.RiverSampler == NodeSampler::Poisson)
+        PointsKey.Add(Params.RiverMinDistance);
+    uint64_t KPoints = PointsKey.Value();
+    StageKey EdgesKey("edges");
+    EdgesKey.Add(KPoints).Add((int)Params.RiverGraph);
+    if (Params.RiverGraph == ProximityGraph::KNN)
+        EdgesKey.Add(Params.RiverNeighbours);
+    else
+        EdgesKey.Add((int)Params.RiverParallelDelaunay);
+    uint64_t KEdges = EdgesKey.Value();
+    StageKey PathKey("path");
+    PathKey.Add(KEdges).Add(Params.RiverTributaries);
+    bool Terrain = uses_terrain_costs(Params);
+    if (Terrain && !Params.Noise.IsEmpty())
+        PathKey.Add(Params.RiverHeightCost).Add(Params.RiverSlopeCost).Add(noise_graph_key(Params.Noise, w, h));
+    else if (Terrain)
+    {
+        PathKey.Add(Params.RiverHeightCost).Add(Params.RiverSlopeCost).Add(w).Add(h)
+               .Add(Params.VoronoiWeight).Add(Params.VoronoiScale)
+               .Add(Params.PerlinWeight).Add(Params.PerlinScale).Add(Params.PerlinOctaves)
+               .Add((int)Params.PerlinMultires);
+    }
+    uint64_t KPath = PathKey.Value();
+    uint64_t KSpline = StageKey("spline").Add(KPath).Add(Params.RiverNodes).Add((int)Params.RiverSpline).Value();
+    uint64_t KBed = StageKey("bed").Add(KSpline).Add(w).Add(h).Add(Params.RiverThickness)
+                                   .Add(Params.GaussKSX).Add(Params.GaussKSY).Add(Params.GaussSigma).Value();
+    if (Cache != nullptr && Cache->Load("bed", KBed, HM))
+        return;
+
+    std::vector<sf::Vector2f> P;
+    auto LoadPoints = [&]()
+    {
+        if (Cache == nullptr || !Cache->Load("points", KPoints, P))
+        {
+            P = river_points(Params.RiverNodes, Params.RiverSeed, Params.RiverSampler, Params.RiverMinDistance,
+                             Params.RiverRng, m_Pool);
+            if (Cache != nullptr)
+                Cache->Store("points", KPoints, P);
+        }
+    };
+
+    // Edges are stored as pairs of consecutive indices
+    auto LoadEdges = [&](std::vector<std::pair<int, int>>& E)
+    {
+        std::vector<int> EIdx;
+        if (Cache != nullptr && Cache->Load("edges", KEdges, EIdx))
+        {
+            for (size_t i = 0; i + 1 < EIdx.size(); i += 2)
+                E.emplace_back(EIdx[i], EIdx[i + 1]);
+            return;
+        }
+        if (Params.RiverGraph == ProximityGraph::KNN)
+            E = knn_graph(P, Params.RiverNeighbours, m_Pool);
+        else
+        {
+            auto DE = Params.RiverParallelDelaunay ? delaunay_parallel(P, m_Pool) : delaunay(P);
+            E.assign(DE.begin(), DE.end());
+            if (Params.RiverGraph == ProximityGraph::Gabriel)
+                E = gabriel_graph(P, E);
+            else if (Params.RiverGraph == ProximityGraph::RNG)
+                E = relative_neighbourhood_graph(P, E);
+        }
+        if (Cache != nullptr)
+        {
+            for (const auto& e : E)
+            {
+                EIdx.push_back(e.first);
+                EIdx.push_back(e.second);
+            }
+            Cache->Store("edges", KEdges, EIdx);
+        }
+    };
+
+    // Edges weigh their length, unless the river follows the terrain
+    auto EdgeCosts = [&](const std::vector<std::pair<int, int>>& E)
+    {
+        std::vector<float> Costs;
+        if (Terrain)
+        {
+            float vw, pw;
+            noise_weights(Params, vw, pw);
+            HeightMap Relief = terrain_relief(*Voronoi, *Perlin, vw, pw);
+            Costs = terrain_edge_costs(Relief, P, E, Params.RiverHeightCost, Params.RiverSlopeCost, 8, m_Pool);
+        }
+        return Costs;
+    };
+
+    if (Params.RiverTributaries > 0)
+    {
+        std::vector<std::vector<sf::Vector2f>> Polylines;
+        std::vector<std::vector<float>> Widths;
+        std::vector<sf::Vector3f> Network;
+        if (Cache != nullptr && Cache->Load("spline", KSpline, Network))
+            unpack_polylines(Network, Polylines, Widths);
+        else
+        {
+            LoadPoints();
+            std::vector<int> Packed;
+            std::vector<std::vector<int>> Branches;
+            if (Cache != nullptr && Cache->Load("path", KPath, Packed))
+                Branches = unpack_branches(Packed);
+            else
+            {
+                std::vector<std::pair<int, int>> E;
+                LoadEdges(E);
+                Branches = river_network(P, E, Params.RiverTributaries, Params.RiverSeed, EdgeCosts(E));
+                if (Cache != nullptr)
+                    Cache->Store("path", KPath, pack_branches(Branches));
+            }
+            river_network_polylines(P, Branches, Params.RiverNodes, Polylines, Widths, Params.RiverSpline);
+            if (Cache != nullptr)
+                Cache->Store("spline", KSpline, pack_polylines(Polylines, Widths));
+        }
+
+        for (auto& W : Widths)
+        {
+            for (float& x : W)
+                x *= Params.RiverThickness;
+        }
+        river_bed(HM, Polylines, Widths, Params.GaussKSX, Params.GaussKSY, Params.GaussSigma,
+                  &m_Canvas, m_Scratch.data(), Params.RiverNarrowBand);
+        if (Cache != nullptr)
+            Cache->Store("bed", KBed, HM);
+        return;
+    }
+
+    std::vector<sf::Vector2f> Polyline;
+    if (Cache == nullptr || !Cache->Load("spline", KSpline, Polyline))
+    {
+        LoadPoints();
+        std::vector<int> Path;
+        if (Cache == nullptr || !Cache->Load("path", KPath, Path))
+        {
+            std::vector<std::pair<int, int>> E;
+            LoadEdges(E);
+            Path = river_path(P, E, EdgeCosts(E));
+            if (Cache != nullptr)
+                Cache->Store("path", KPath, Path);
+        }
+
+        Polyline = river_polyline(P, Path, Params.RiverNodes, Params.RiverSpline);
+        if (Cache != nullptr)
+            Cache->Store("spline", KSpline, Polyline);
+    }
+
+    river_bed(HM, Polyline, Params.RiverThickness, Params.GaussKSX, Params.GaussKSY, Params.GaussSigma,
+              &m_Canvas, m_Scratch.data(), Params.RiverNarrowBand);
+    if (Cache != nullptr)
+        Cache->Store("bed", KBed, HM);
+}
+
+
+namespace
+{
+
+// Zero a layer, reusing its memory if it has the right size
+void reset_layer(HeightMap& L, int w, int h)
+{
+    if (L.GetWidth() != w || L.GetHeight() != h)
+    {
+        L = HeightMap(w, h);
+        return;
+    }
+    std::fill(L.RawData(), L.RawData() + (size_t)w * h, 0.0f);
+    L.SetRange(0.0f, 0.0f);
+}
+
+} // namespace
+
+
+// The bed chain and the two noise layers do not depend on each other, so
+// they run as independent tasks when the generator has a pool, unless the
+// river follows the terrain of the noise layers.
+void RiverGenerator::GenerateLayers(const RiverParams& Params, HeightMap& Bed, HeightMap& Voronoi, HeightMap& Perlin)
+{
+    int w = Bed.GetWidth();
+    int h = Bed.GetHeight();
+    size_t ScratchSize = gauss_blur_scratch_size(w, h, Params.GaussKSX, Params.GaussKSY);
+    if (m_Scratch.size() < ScratchSize)
+        m_Scratch.resize(ScratchSize);
+
+    std::unique_ptr<StageCache> Cache;
+    if (!Params.CacheDir.empty())
+        Cache.reset(new StageCache(Params.CacheDir));
+
+    auto BedTask = [&]() { GenerateBed(Params, Bed, Cache.get(), &Voronoi, &Perlin); };
+
+    // Noise layers are generated with unit weight, and a noise graph goes in the Perlin layer
+    auto VoronoiTask = [&]()
+    {
+        if (!Params.Noise.IsEmpty())
+        {
+            reset_layer(Voronoi, w, h);
+            return;
+        }
+        uint64_t KVoronoi = StageKey("voronoi").Add(w).Add(h).Add(Params.VoronoiScale).Value();
+        reset_layer(Voronoi, w, h);
+        if (Cache == nullptr || !Cache->Load("voronoi", KVoronoi, Voronoi))
+        {
+            add_voronoi(Voronoi, 1.0f, Params.VoronoiScale);
+            if (Cache != nullptr)
+                Cache->Store("voronoi", KVoronoi, Voronoi);
+        }
+    };
+
+    auto PerlinTask = [&]()
+    {
+        if (!Params.Noise.IsEmpty())
+        {
+            uint64_t KNoise = noise_graph_key(Params.Noise, w, h);
+            reset_layer(Perlin, w, h);
+            if (Cache == nullptr || !Cache->Load("noise_graph", KNoise, Perlin))
+            {
+                Params.Noise.Evaluate(Perlin);
+                if (Cache != nullptr)
+                    Cache->Store("noise_graph", KNoise, Perlin);
+            }
+            return;
+        }
+        uint64_t KPerlin = StageKey("perlin").Add(w).Add(h).Add(Params.PerlinScale).Add(Params.PerlinOctaves)
+                                             .Add((int)Params.PerlinMultires).Value();
+        reset_layer(Perlin, w, h);
+        if (Cache == nullptr || !Cache->Load("perlin", KPerlin, Perlin))
+        {
+            add_perlin(Perlin, 1.0f, Params.PerlinScale, Params.PerlinOctaves, Params.PerlinMultires);
+            if (Cache != nullptr)
+                Cache->Store("perlin", KPerlin, Perlin);
+        }
+    };
+
+    TaskGraph Tasks;
+    if (uses_terrain_costs(Params))
+    {
+        int VoronoiId = Tasks.Add(VoronoiTask);
+        int PerlinId = Tasks.Add(PerlinTask);
+        Tasks.Add(BedTask, { VoronoiId, PerlinId });
+    }
+    else
+    {
+        Tasks.Add(BedTask);
+        Tasks.Add(VoronoiTask);
+        Tasks.Add(PerlinTask);
+    }
+
+    Tasks.Run(m_Pool);
+}
+
+void RiverGenerator::GenerateLayers(const RiverParams& Params, LayerStack& Stack)
+{
+    RT_PROFILE_SCOPE("generate_layers");
+    // The range of the bed is part of the result, so it must start from a new map
+    Stack.Bed() = HeightMap(Stack.GetWidth(), Stack.GetHeight());
+    GenerateLayers(Params, Stack.Bed(), Stack.Voronoi(), Stack.Perlin());
+}
+
+
+// C interface
+
+struct rt_generator
+{
+    RiverGenerator Gen;
+    std::string Error;
+};
+
+void rt_params_default(rt_params* params)
+{
+    params->width = 1024;
+    params->height = 1024;
+    params->perlin_weight = 0.8f;
+    params->perlin_scale = 5.0f;
+    params->perlin_octaves = 6;
+    params->voronoi_weight = 0.4f;
+    params->voronoi_scale = 6.0f;
+    params->river_nodes = 100;
+    params->river_samples = 30;
+    params->river_thickness = 150.0f;
+    params->river_seed = 0;
+    params->gauss_ksx = 60;
+    params->gauss_ksy = 0;
+    params->gauss_sigma = 10.0f;
+    params->plane_delta = 3.0f;
+}
+
+rt_generator* rt_generator_create(void)
+{
+    return new (std::nothrow) rt_generator();
+}
+
+void rt_generator_destroy(rt_generator* gen)
+{
+    delete gen;
+}
+
+int rt_generate(rt_generator* gen, const rt_params* params, float* out)
+{
+    if (gen == nullptr)
+        return -1;
+    if (params == nullptr || out == nullptr || params->width < 2 || params->height < 2)
+    {
+        gen->Error = "Invalid generation parameters.";
+        return -1;
+    }
+
+    RiverParams P = { };
+    P.Width = params->width;
+    P.Height = params->height;
+    P.PerlinWeight = params->perlin_weight;
+    P.PerlinScale = params->perlin_scale;
+    P.PerlinOctaves = params->perlin_octaves;
+    P.VoronoiWeight = params->voronoi_weight;
+    P.VoronoiScale = params->voronoi_scale;
+    P.RiverNodes = params->river_nodes;
+    P.RiverSamples = params->river_samples;
+    P.RiverThickness = params->river_thickness;
+    P.RiverSeed = params->river_seed;
+    P.GaussKSX = params->gauss_ksx;
+    P.GaussKSY = params->gauss_ksy;
+    P.GaussSigma = params->gauss_sigma;
+    P.PlaneDelta = params->plane_delta;
+
+    // The attributes that rt_params does not expose take the defaults of the
+    // configuration files, so that C callers run the same code paths
+    P.RiverSampler = NodeSampler::Uniform;
+    P.RiverRng = NodeRng::MT19937;
+    P.RiverGraph = ProximityGraph::Delaunay;
+    P.RiverNeighbours = 8;
+    P.RiverSpline = SplineType::Natural;
+    P.RiverNarrowBand = true;
+    P.PlaneFilter = ResampleFilter::Bilinear;
+    P.OutBitDepth = 8;
+
+    try
+    {
+        gen->Gen.Generate(P, out);
+    }
+    catch(const std::exception& e)
+    {
+        gen->Error = e.what();
+        return -1;
+    }
+    gen->Error.clear();
+    return 0;
+}
+
+const char* rt_generator_error(const rt_generator* gen)
+{
+    return gen != nullptr ? gen->Error.c_str() : "";
+}
\ No newline at end of file
@@ -0,0 +1,178 @@
+/**
+ * @file        sampling.cpp
+ *
+ * @brief       Implements the point samplers.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <sampling.hpp>
+#include <profiler.hpp>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+
+NodeSampler parse_node_sampler(const std::string& name)
+{
+    if (name == "uniform")
+        return NodeSampler::Uniform;
+    if (name == "poisson")
+        return NodeSampler::Poisson;
+
+    std::stringstream ss;
+    ss << "Unknown node sampler \"" << name << "\".";
+    throw std::runtime_error(ss.str());
+}
+
+
+NodeRng parse_node_rng(const std::string& name)
+{
+    if (name == "mt19937")
+        return NodeRng::MT19937;
+    if (name == "philox")
+        return NodeRng::Philox;
+
+    std::stringstream ss;
+    ss << "Unknown random number generator \"" << name << "\".";
+    throw std::runtime_error(ss.str());
+}
+
+
+sf::Vector2f philox_point(uint64_t Seed, uint64_t Index, uint32_t Domain)
+{
+    uint32_t Ctr[4] = { (uint32_t)Index, (uint32_t)(Index >> 32), Domain, 0 };
+    uint32_t Key[2] = { (uint32_t)Seed, (uint32_t)(Seed >> 32) };
+    uint32_t Out[4];
+    philox4x32(Ctr, Key, Out);
+    return sf::Vector2f(philox_unit(Out[0]), philox_unit(Out[1]));
+}
+
+void philox_points(uint64_t Seed, uint64_t First, size_t Count, sf::Vector2f* Out, ThreadPool* Pool)
+{
+    RT_PROFILE_SCOPE("philox_points");
+    parallel_for(Pool, Count, 1 << 16, [Seed, First, Out](size_t Begin, size_t End)
+    {
+        for (size_t i = Begin; i < End; ++i)
+            Out[i] = philox_point(Seed, First + i);
+    });
+}
+
+
+float poisson_disk_distance(int Points)
+{
+    // Bridson's sets have about 0.62 / r^2 points per unit area
+    return std::sqrt(0.62f / std::max(1, Points));
+}
+
+int poisson_disk_capacity(float MinDistance)
+{
+    // Discs of radius r/2 around the points are disjoint and lie in the square
+    // grown by r/2, and cover at most pi / (2 sqrt(3)) of its area
+    if (MinDistance <= 0.0f)
+        return std::numeric_limits<int>::max();
+    double r = MinDistance;
+    double N = std::floor(2.0 * (1.0 + r) * (1.0 + r) / (std::sqrt(3.0) * r * r));
+    return (int)std::min(N, (double)std::numeric_limits<int>::max());
+}
+
+
+template<typename Engine>
+std::vector<sf::Vector2f> poisson_disk(float MinDistance, int MaxPoints, Engine& Eng, int Attempts)
+{
+    RT_PROFILE_SCOPE("poisson_disk");
+    if (MinDistance <= 0.0f)
+    {
+        std::stringstream ss;
+        ss << "The minimum distance of Poisson-disk sampling must be positive, not " << MinDistance << '.';
+        throw std::runtime_error(ss.str());
+    }
+
+    // Engine outputs are used directly, as the standard distributions differ
+    // between implementations
+    auto Unit = [&Eng]() { return philox_unit((uint32_t)Eng()); };
+    std::vector<sf::Vector2f> P;
+    if (MaxPoints <= 0)
+        return P;
+
+    // Each cell is small enough to contain at most one point
+    float Cell = MinDistance / std::sqrt(2.0f);
+    int n = std::max(1, (int)std::ceil(1.0f / Cell));
+    std::vector<int> Grid((size_t)n * n, -1);
+    auto CellOf = [n, Cell](float x) { return std::min(n - 1, (int)(x / Cell)); };
+    float r2 = MinDistance * MinDistance;
+
+    auto Insert = [&](const sf::Vector2f& p)
+    {
+        Grid[(size_t)CellOf(p.y) * n + CellOf(p.x)] = (int)P.size();
+        P.push_back(p);
+    };
+
+    // Points closer than MinDistance can only be in the 5x5 cells around p
+    auto IsFar = [&](const sf::Vector2f& p)
+    {
+        int ci = CellOf(p.x);
+        int cj = CellOf(p.y);
+        for (int j = std::max(0, cj - 2); j <= std::min(n - 1, cj + 2); ++j)
+        {
+            for (int i = std::max(0, ci - 2); i <= std::min(n - 1, ci + 2); ++i)
+            {
+                int k = Grid[(size_t)j * n + i];
+                if (k < 0)
+                    continue;
+                float dx = P[k].x - p.x;
+                float dy = P[k].y - p.y;
+                if (dx * dx + dy * dy < r2)
+                    return false;
+            }
+        }
+        return true;
+    };
+
+    std::vector<int> Active;
+    float x = Unit();
+    float y = Unit();
+    Insert(sf::Vector2f(x, y));
+    Active.push_back(0);
+    while (!Active.empty() && (int)P.size() < MaxPoints)
+    {
+        int a = (int)(((uint64_t)(uint32_t)Eng() * Active.size()) >> 32);
+        sf::Vector2f Center = P[Active[a]];
+        bool Found = false;
+        for (int t = 0; t < Attempts && !Found; ++t)
+        {
+            // Uniform in the area of the annulus between r and 2r, by rejection from
+            // its bounding square rather than with the library's trigonometry
+            float dx, dy, d2;
+            do
+            {
+                dx = (4.0f * Unit() - 2.0f) * MinDistance;
+                dy = (4.0f * Unit() - 2.0f) * MinDistance;
+                d2 = dx * dx + dy * dy;
+            } while (d2 < r2 || d2 >= 4.0f * r2);
+            sf::Vector2f q(Center.x + dx, Center.y + dy);
+            if (q.x < 0.0f || q.x >= 1.0f || q.y < 0.0f || q.y >= 1.0f || !IsFar(q))
+                continue;
+            Active.push_back((int)P.size());
+            Insert(q);
+            Found = true;
+        }
+
+        // Points without room around them are retired
+        if (!Found)
+        {
+            Active[a] = Active.back();
+            Active.pop_back();
+        }
+    }
+
+    RT_PROFILE_COUNT("poisson_disk.points", (int64_t)P.size());
+    return P;
+}
+
+template std::vector<sf::Vector2f> poisson_disk(float, int, std::mt19937&, int);
+template std::vector<sf::Vector2f> poisson_disk(float, int, Philox4x32&, int);
\ No newline at end of file
@@ -54,15 +54,14 @@ sfLine& sfLine::operator=(const sfLine& line)
 void sfLine::draw(sf::RenderTarget &target, 
                   const sf::RenderStates& states) const
 {
-    sf::RectangleShape r({ m_len, m_thick });
-    r.setPosition(m_pos);
-    r.setRotation(m_rot);
-    r.setFillColor(m_col1);
-    target.draw(r);
-    r.scale({ -1.0f, 1.0f });
-    target.draw(r);
-    r.scale({ 1.0f, -1.0f });
-    target.draw(r);
-    r.scale({ -1.0f, 1.0f });
-    target.draw(r);
+    // The rectangle is two triangles of a single vertex array
+    float angle = m_rot.asRadians();
+    sf::Vector2f u = m_len * sf::Vector2f(std::cos(angle), std::sin(angle));
+    sf::Vector2f n = m_thick * sf::Vector2f(-std::sin(angle), std::cos(angle));
+    sf::VertexArray quad(sf::PrimitiveType::TriangleStrip, 4);
+    quad[0] = sf::Vertex{ m_pos - u - n, m_col1 };
+    quad[1] = sf::Vertex{ m_pos - u + n, m_col1 };
+    quad[2] = sf::Vertex{ m_pos + u - n, m_col1 };
+    quad[3] = sf::Vertex{ m_pos + u + n, m_col1 };
+    target.draw(quad, states);
 }
\ No newline at end of file
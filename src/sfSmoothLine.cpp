@@ -11,6 +11,7 @@
  */
 #include <sfSmoothLine.hpp>
 #include <cmath>
+#include <algorithm>
 
 
 sfSmoothLine::sfSmoothLine(const sf::Vector2f& point1, 
@@ -51,23 +52,25 @@ void sfSmoothLine::draw(sf::RenderTarget &target,
         return;
     }
 
-    float thickness = m_thick;
-    sf::RectangleShape rect({ 1.0f, 1.0f });
-    rect.setPosition(m_pos);
-    rect.setRotation(m_rot);
-    sf::Color col = m_col2;
-
-    for (; thickness >= 1.0f; thickness -= 1.0f)
+    // A triangle strip across the line, with one pair of vertices per pixel of
+    // distance from the center, colored with the gradient at that distance
+    float angle = m_rot.asRadians();
+    sf::Vector2f u = m_len * sf::Vector2f(std::cos(angle), std::sin(angle));
+    sf::Vector2f n(-std::sin(angle), std::cos(angle));
+    int steps = (int)std::ceil(m_thick);
+    sf::VertexArray strip(sf::PrimitiveType::TriangleStrip, 2 * (2 * steps + 1));
+    float r1 = m_col1.r / 255.0f;
+    float g1 = m_col1.g / 255.0f;
+    float b1 = m_col1.b / 255.0f;
+    float a1 = m_col1.a / 255.0f;
+    float r2 = m_col2.r / 255.0f;
+    float g2 = m_col2.g / 255.0f;
+    float b2 = m_col2.b / 255.0f;
+    float a2 = m_col2.a / 255.0f;
+    for (int k = -steps; k <= steps; ++k)
     {
-        float t = (thickness - 1) / (m_thick - 1);
-        float r1 = m_col1.r / 255.0f;
-        float g1 = m_col1.g / 255.0f;
-        float b1 = m_col1.b / 255.0f;
-        float a1 = m_col1.a / 255.0f;
-        float r2 = m_col2.r / 255.0f;
-        float g2 = m_col2.g / 255.0f;
-        float b2 = m_col2.b / 255.0f;
-        float a2 = m_col2.a / 255.0f;
+        float thickness = std::min((float)std::abs(k), m_thick);
+        float t = thickness / m_thick;
         float r, g, b, a;
         if (m_gammaCorr)
         {
@@ -83,17 +86,11 @@ void sfSmoothLine::draw(sf::RenderTarget &target,
             b = (1 - t) * b1 + t * b2;
             a = (1 - t) * a1 + t * a2;
         }
-        col = sf::Color(255 * r, 255 * g, 255 * b, 255 * a);
-
-        rect.setFillColor(col);
-        rect.setScale({ m_len, thickness });
-        target.draw(rect, states);
-        rect.setScale({ -m_len, thickness });
-        target.draw(rect, states);
-        rect.setScale({ m_len, -thickness });
-        target.draw(rect, states);
-        rect.setScale({ -m_len, -thickness });
-        target.draw(rect, states);
+        sf::Color col(255 * r, 255 * g, 255 * b, 255 * a);
 
+        sf::Vector2f o = m_pos + (k < 0 ? -thickness : thickness) * n;
+        strip[2 * (k + steps)] = sf::Vertex{ o - u, col };
+        strip[2 * (k + steps) + 1] = sf::Vertex{ o + u, col };
     }
+    target.draw(strip, states);
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+/**
+ * @file        sfStroke.cpp
+ *
+ * @brief       Implements sfStroke.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <sfStroke.hpp>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+
+
+sfStroke::sfStroke(const sf::Color& color)
+    : m_verts(sf::PrimitiveType::Triangles)
+{
+    m_col1 = color;
+    m_col2 = color;
+    m_gammaCorr = false;
+    m_bands = 1;
+}
+
+sfStroke::sfStroke(const sf::Color& inCol,
+                   const sf::Color& outCol,
+                   bool gammaCorr)
+    : m_verts(sf::PrimitiveType::Triangles)
+{
+    m_col1 = inCol;
+    m_col2 = outCol;
+    m_gammaCorr = gammaCorr;
+    // Eight linear pieces are within a couple of levels of the gamma-corrected ramp
+    m_bands = gammaCorr && inCol != outCol ? 8 : 1;
+}
+
+
+sf::Color sfStroke::Gradient(float t) const
+{
+    float c1[4] = { (float)m_col1.r, (float)m_col1.g, (float)m_col1.b, (float)m_col1.a };
+    float c2[4] = { (float)m_col2.r, (float)m_col2.g, (float)m_col2.b, (float)m_col2.a };
+    std::uint8_t c[4];
+    for (int k = 0; k < 4; ++k)
+    {
+        float v;
+        if (m_gammaCorr)
+            v = std::sqrt((1 - t) * c1[k] * c1[k] + t * c2[k] * c2[k]);
+        else
+            v = (1 - t) * c1[k] + t * c2[k];
+        c[k] = (std::uint8_t)std::min(255.0f, std::round(v));
+    }
+    return sf::Color(c[0], c[1], c[2], c[3]);
+}
+
+void sfStroke::AddQuad(const sf::Vector2f& a0, const sf::Vector2f& a1,
+                       const sf::Vector2f& b0, const sf::Vector2f& b1,
+                       const sf::Color& c0, const sf::Color& c1)
+{
+    m_verts.append(sf::Vertex{ a0, c0 });
+    m_verts.append(sf::Vertex{ a1, c1 });
+    m_verts.append(sf::Vertex{ b1, c1 });
+    m_verts.append(sf::Vertex{ a0, c0 });
+    m_verts.append(sf::Vertex{ b1, c1 });
+    m_verts.append(sf::Vertex{ b0, c0 });
+}
+
+void sfStroke::AddDisc(const sf::Vector2f& center, float radius)
+{
+    if (radius <= 0.0f)
+        return;
+
+    // Enough sides for the polygon to be within a quarter of pixel of the circle
+    float Step = std::acos(std::max(-1.0f, 1.0f - 0.25f / radius));
+    int nSides = std::clamp((int)std::ceil(2.0f * 3.14159265f / Step), 8, 64);
+    sf::Vector2f Prev(radius, 0.0f);
+    for (int s = 1; s <= nSides; ++s)
+    {
+        float Theta = 2.0f * 3.14159265f * s / nSides;
+        sf::Vector2f Next(radius * std::cos(Theta), radius * std::sin(Theta));
+        sf::Color c0 = m_col1;
+        for (int b = 0; b < m_bands; ++b)
+        {
+            float f0 = (float)b / m_bands;
+            float f1 = (float)(b + 1) / m_bands;
+            sf::Color c1 = Gradient(f1);
+            if (b == 0)
+            {
+                m_verts.append(sf::Vertex{ center, c0 });
+                m_verts.append(sf::Vertex{ center + f1 * Prev, c1 });
+                m_verts.append(sf::Vertex{ center + f1 * Next, c1 });
+            }
+            else
+                AddQuad(center + f0 * Prev, center + f1 * Prev, center + f0 * Next, center + f1 * Next, c0, c1);
+            c0 = c1;
+        }
+        Prev = Next;
+    }
+}
+
+void sfStroke::AddSegment(const sf::Vector2f& p0, const sf::Vector2f& p1, float r0, float r1)
+{
+    sf::Vector2f d = p1 - p0;
+    float len = d.length();
+    if (len <= 0.0f)
+        return;
+    sf::Vector2f n(-d.y / len, d.x / len);
+
+    // A uniform stroke is a single quad, a gradient goes outwards on both sides
+    if (m_col1 == m_col2)
+    {
+        AddQuad(p0 - r0 * n, p0 + r0 * n, p1 - r1 * n, p1 + r1 * n, m_col1, m_col1);
+        return;
+    }
+    sf::Color c0 = m_col1;
+    for (int b = 0; b < m_bands; ++b)
+    {
+        float f0 = (float)b / m_bands;
+        float f1 = (float)(b + 1) / m_bands;
+        sf::Color c1 = Gradient(f1);
+        AddQuad(p0 + f0 * r0 * n, p0 + f1 * r0 * n, p1 + f0 * r1 * n, p1 + f1 * r1 * n, c0, c1);
+        AddQuad(p0 - f0 * r0 * n, p0 - f1 * r0 * n, p1 - f0 * r1 * n, p1 - f1 * r1 * n, c0, c1);
+        c0 = c1;
+    }
+}
+
+
+void sfStroke::Add(const std::vector<sf::Vector2f>& points, const std::vector<float>& thickness)
+{
+    if (points.size() != thickness.size())
+    {
+        std::stringstream ss;
+        ss << "A polyline of " << points.size() << " points cannot have " << thickness.size() << " thickness values.";
+        throw std::runtime_error(ss.str());
+    }
+
+    // As with the circles that joined sfLine segments, the first point has no disc
+    for (size_t i = 1; i < points.size(); ++i)
+    {
+        AddSegment(points[i - 1], points[i], thickness[i - 1] / 2, thickness[i] / 2);
+        AddDisc(points[i], thickness[i] / 2);
+    }
+}
+
+void sfStroke::Clear()
+{
+    m_verts.clear();
+}
+
+size_t sfStroke::GetVertexCount() const
+{
+    return m_verts.getVertexCount();
+}
+
+
+void sfStroke::draw(sf::RenderTarget &target,
+                    const sf::RenderStates& states) const
+{
+    target.draw(m_verts, states);
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+/**
+ * @file        spectral.cpp
+ *
+ * @brief       Implements the spectral synthesis of fractal noise.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <noises.hpp>
+#include <rng.hpp>
+#include <profiler.hpp>
+#include <unsupported/Eigen/FFT>
+#include <complex>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+
+HeightMap spectral(int width, int height, float beta, int seed)
+{
+    HeightMap HM(width, height);
+    add_spectral(HM, 1.0f, beta, seed);
+    return HM;
+}
+
+
+// White noise is transformed by rows (real to half spectrum) and by columns,
+// filtered, and transformed back in the opposite order. Columns are processed
+// in blocks, so that they are gathered from the rows sequentially.
+void add_spectral(HeightMap& HM, float alpha, float beta, int seed)
+{
+    RT_PROFILE_SCOPE("spectral");
+    int w = HM.GetWidth();
+    int h = HM.GetHeight();
+    int nx = w / 2 + 1;
+    std::vector<std::complex<float>> Spec((size_t)h * nx);
+    Eigen::FFT<float> fft;
+    fft.SetFlag(Eigen::FFT<float>::HalfSpectrum);
+    fft.SetFlag(Eigen::FFT<float>::Unscaled);
+
+    // Uniform white noise in [-1, 1), one Philox block for every four pixels
+    {
+        RT_PROFILE_SCOPE("spectral.rows");
+        const uint32_t Domain = 0x53504543u;
+        uint32_t Key[2] = { (uint32_t)seed, 0u };
+        uint32_t Out[4];
+        std::vector<float> Row(w);
+        for (int j = 0; j < h; ++j)
+        {
+            for (int i = 0; i < w; ++i)
+            {
+                uint64_t k = (uint64_t)j * w + i;
+                if (i == 0 || (k & 3) == 0)
+                {
+                    uint32_t Ctr[4] = { (uint32_t)(k >> 2), (uint32_t)(k >> 34), Domain, 0 };
+                    philox4x32(Ctr, Key, Out);
+                }
+                Row[i] = 2.0f * philox_unit(Out[k & 3]) - 1.0f;
+            }
+            fft.fwd(Spec.data() + (size_t)j * nx, Row.data(), w);
+        }
+    }
+
+    // Amplitudes fall as f^(-beta / 2), with f in cycles per pixel, so that the
+    // power spectrum falls as 1 / f^beta on maps of any aspect ratio
+    {
+        RT_PROFILE_SCOPE("spectral.columns");
+        std::vector<float> Gain(h);
+        const int Block = 16;
+        std::vector<std::complex<float>> Cols((size_t)Block * h);
+        std::vector<std::complex<float>> Tmp(h);
+        for (int c0 = 0; c0 < nx; c0 += Block)
+        {
+            int nc = std::min(Block, nx - c0);
+            for (int j = 0; j < h; ++j)
+            {
+                for (int c = 0; c < nc; ++c)
+                    Cols[(size_t)c * h + j] = Spec[(size_t)j * nx + c0 + c];
+            }
+            for (int c = 0; c < nc; ++c)
+            {
+                float fx = (c0 + c) / (float)w;
+                for (int j = 0; j < h; ++j)
+                {
+                    float fy = (j <= h / 2 ? j : j - h) / (float)h;
+                    float f2 = fx * fx + fy * fy;
+                    Gain[j] = f2 > 0.0f ? std::pow(f2, -0.25f * beta) : 0.0f;
+                }
+                std::complex<float>* Col = Cols.data() + (size_t)c * h;
+                fft.fwd(Tmp.data(), Col, h);
+                for (int j = 0; j < h; ++j)
+                    Tmp[j] *= Gain[j];
+                fft.inv(Col, Tmp.data(), h);
+            }
+            for (int j = 0; j < h; ++j)
+            {
+                for (int c = 0; c < nc; ++c)
+                    Spec[(size_t)j * nx + c0 + c] = Cols[(size_t)c * h + j];
+            }
+        }
+    }
+
+    // The field is periodic over the map, and it is scaled to [-1, 1]
+    std::vector<float> Field((size_t)w * h);
+    for (int j = 0; j < h; ++j)
+        fft.inv(Field.data() + (size_t)j * w, Spec.data() + (size_t)j * nx, w);
+    float Peak = 0.0f;
+    for (float v : Field)
+        Peak = std::max(Peak, std::abs(v));
+    float Scale = Peak > 0.0f ? alpha / Peak : 0.0f;
+    for (int j = 0; j < h; ++j)
+    {
+        for (int i = 0; i < w; ++i)
+            HM.Set(i, j, HM(i, j) + Scale * Field[(size_t)j * w + i]);
+    }
+}
\ No newline at end of file
@@ -10,11 +10,29 @@
  * @date        2023-08-24
  */
 #include <spline.hpp>
+#include <profiler.hpp>
 #include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
 
 
-Spline::Spline(const std::vector<sf::Vector2f>& P)
+SplineType parse_spline_type(const std::string& name)
 {
+    if (name == "natural")
+        return SplineType::Natural;
+    if (name == "catmull_rom")
+        return SplineType::CatmullRom;
+
+    std::stringstream ss;
+    ss << "Unknown spline type \"" << name << "\".";
+    throw std::runtime_error(ss.str());
+}
+
+
+Spline::Spline(const std::vector<sf::Vector2f>& P, SplineType Type) : m_Type(Type)
+{
+    RT_PROFILE_SCOPE("spline");
     m_X.resize(P.size());
     m_Y.resize(P.size());
     for (int i = 0; i < P.size(); ++i)
@@ -25,6 +43,10 @@ Spline::Spline(const std::vector<sf::Vector2f>& P)
     m_T = Eigen::VectorXf::LinSpaced(P.size(), 0.0f, P.size() - 1);
     m_T /= P.size() - 1;
 
+    // Catmull-Rom segments are computed on the fly from the points
+    if (m_Type == SplineType::CatmullRom)
+        return;
+
     // This should be made sparse, but these systems are usually very small,
     // so we go for the easy solution
     Eigen::MatrixXf M;
@@ -67,6 +89,7 @@ Spline::Spline(const std::vector<sf::Vector2f>& P)
 
 Spline::Spline(const Spline& S)
 {
+    m_Type = S.m_Type;
     m_T = S.m_T;
     m_X = S.m_X;
     m_Y = S.m_Y;
@@ -76,6 +99,7 @@ Spline::Spline(const Spline& S)
 
 Spline& Spline::operator=(const Spline& S)
 {
+    m_Type = S.m_Type;
     m_T = S.m_T;
     m_X = S.m_X;
     m_Y = S.m_Y;
@@ -93,6 +117,19 @@ sf::Vector2f Spline::Evaluate(float t) const
         throw std::runtime_error("t outside range [0, 1].");
     }
 
+    if (m_Type == SplineType::CatmullRom)
+    {
+        // Points are evenly spaced, so the segment is found directly
+        int n = m_X.size();
+        float x = t * (n - 1);
+        int i = std::min(n - 2, (int)x);
+        sf::Vector2f P1(m_X[i], m_Y[i]);
+        sf::Vector2f P2(m_X[i + 1], m_Y[i + 1]);
+        sf::Vector2f P0 = i > 0 ? sf::Vector2f(m_X[i - 1], m_Y[i - 1]) : 2.0f * P1 - P2;
+        sf::Vector2f P3 = i + 2 < n ? sf::Vector2f(m_X[i + 2], m_Y[i + 2]) : 2.0f * P2 - P1;
+        return Segment(P0, P1, P2, P3, x - i);
+    }
+
     int i;
     for (i = 0; t > m_T[i + 1]; ++i) { }
 
@@ -115,4 +152,24 @@ sf::Vector2f Spline::Evaluate(float t) const
 sf::Vector2f Spline::operator()(float t) const
 {
     return Evaluate(t);
+}
+
+// Barry and Goldman's pyramidal form, with knots spaced by the square root of
+// the chords, which never makes cusps or loops within a segment
+sf::Vector2f Spline::Segment(const sf::Vector2f& P0, const sf::Vector2f& P1, const sf::Vector2f& P2,
+                             const sf::Vector2f& P3, float u)
+{
+    // Repeated points would give empty knot intervals
+    auto Knot = [](const sf::Vector2f& a, const sf::Vector2f& b) { return std::max(std::sqrt((b - a).length()), 1e-4f); };
+    float t1 = Knot(P0, P1);
+    float t2 = t1 + Knot(P1, P2);
+    float t3 = t2 + Knot(P2, P3);
+    float t = t1 + u * (t2 - t1);
+
+    sf::Vector2f A1 = ((t1 - t) * P0 + t * P1) / t1;
+    sf::Vector2f A2 = ((t2 - t) * P1 + (t - t1) * P2) / (t2 - t1);
+    sf::Vector2f A3 = ((t3 - t) * P2 + (t - t2) * P3) / (t3 - t2);
+    sf::Vector2f B1 = ((t2 - t) * A1 + t * A2) / t2;
+    sf::Vector2f B2 = ((t3 - t) * A2 + (t - t1) * A3) / (t3 - t1);
+    return ((t2 - t) * B1 + (t - t1) * B2) / (t2 - t1);
 }
\ No newline at end of file
@@ -0,0 +1,246 @@
+/**
+ * @file        tasks.cpp
+ *
+ * @brief       Implements ThreadPool and TaskGraph.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <tasks.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+
+
+namespace
+{
+
+// The pool and the queue of the worker running on this thread, if any
+thread_local const ThreadPool* t_Pool = nullptr;
+thread_local int t_Self = -1;
+
+} // namespace
+
+
+ThreadPool::ThreadPool(int Threads)
+    : m_Pending(0), m_Next(0), m_Stop(false)
+{
+    if (Threads <= 0)
+        Threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < Threads; ++i)
+        m_Queues.emplace_back(new Queue);
+    for (int i = 0; i < Threads; ++i)
+        m_Workers.emplace_back(&ThreadPool::Loop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> Guard(m_Lock);
+        m_Stop = true;
+    }
+    m_Wake.notify_all();
+    for (auto& t : m_Workers)
+        t.join();
+}
+
+int ThreadPool::GetThreads() const { return (int)m_Workers.size(); }
+
+
+void ThreadPool::Submit(std::function<void()> Task)
+{
+    int n = (int)m_Queues.size();
+    int Target = t_Pool == this ? t_Self : (int)(m_Next++ % n);
+    {
+        std::lock_guard<std::mutex> Guard(m_Queues[Target]->Lock);
+        m_Queues[Target]->Tasks.push_back(std::move(Task));
+    }
+    {
+        std::lock_guard<std::mutex> Guard(m_Lock);
+        m_Pending++;
+    }
+    m_Wake.notify_one();
+}
+
+bool ThreadPool::Pop(int Self, std::function<void()>& Task)
+{
+    int n = (int)m_Queues.size();
+    if (Self >= 0)
+    {
+        Queue& Q = *m_Queues[Self];
+        std::lock_guard<std::mutex> Guard(Q.Lock);
+        if (!Q.Tasks.empty())
+        {
+            Task = std::move(Q.Tasks.back());
+            Q.Tasks.pop_back();
+            m_Pending--;
+            return true;
+        }
+    }
+
+    // Steal the oldest task of another queue, starting from the next one
+    int First = Self >= 0 ? Self + 1 : 0;
+    for (int k = 0; k < n; ++k)
+    {
+        int i = (First + k) % n;
+        if (i == Self)
+            continue;
+        Queue& Q = *m_Queues[i];
+        std::lock_guard<std::mutex> Guard(Q.Lock);
+        if (!Q.Tasks.empty())
+        {
+            Task = std::move(Q.Tasks.front());
+            Q.Tasks.pop_front();
+            m_Pending--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::Loop(int Self)
+{
+    t_Pool = this;
+    t_Self = Self;
+    std::function<void()> Task;
+    while (true)
+    {
+        if (Pop(Self, Task))
+        {
+            Task();
+            Task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> Guard(m_Lock);
+        m_Wake.wait(Guard, [this]() { return m_Stop || m_Pending > 0; });
+        if (m_Stop && m_Pending <= 0)
+            return;
+    }
+}
+
+bool ThreadPool::RunPending()
+{
+    std::function<void()> Task;
+    if (!Pop(t_Pool == this ? t_Self : -1, Task))
+        return false;
+    Task();
+    return true;
+}
+
+
+TaskGraph::TaskGraph() : m_Done(0), m_Failed(false) { }
+
+int TaskGraph::Add(std::function<void()> Fn, const std::vector<int>& Deps)
+{
+    int Id = (int)m_Nodes.size();
+    for (int d : Deps)
+    {
+        // Dependencies on earlier tasks only also rule out cycles
+        if (d < 0 || d >= Id)
+        {
+            std::stringstream ss;
+            ss << "Task " << Id << " cannot depend on task " << d << ", which was not added before it.";
+            throw std::runtime_error(ss.str());
+        }
+    }
+
+    m_Nodes.emplace_back(new Node);
+    m_Nodes.back()->Fn = std::move(Fn);
+    m_Nodes.back()->nDeps = (int)Deps.size();
+    for (int d : Deps)
+        m_Nodes[d]->Next.push_back(Id);
+    return Id;
+}
+
+
+void TaskGraph::Execute(ThreadPool& Pool, int Task)
+{
+    Node& N = *m_Nodes[Task];
+    if (!m_Failed)
+    {
+        try
+        {
+            N.Fn();
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> Guard(m_Lock);
+            if (!m_Failed.exchange(true))
+                m_Error = std::current_exception();
+        }
+    }
+
+    // Successors are queued before the completion is signalled, so that a
+    // waiting thread that wakes up can always find them
+    for (int s : N.Next)
+    {
+        if (--m_Nodes[s]->Remaining == 0)
+            Pool.Submit([this, &Pool, s]() { Execute(Pool, s); });
+    }
+    // Notified under the lock, since the graph may be destroyed as soon as
+    // the waiting thread sees the last completion
+    std::lock_guard<std::mutex> Guard(m_Lock);
+    m_Done++;
+    m_Progress.notify_all();
+}
+
+void TaskGraph::Run(ThreadPool* Pool)
+{
+    m_Done = 0;
+    m_Error = nullptr;
+    m_Failed = false;
+
+    if (Pool == nullptr)
+    {
+        for (auto& N : m_Nodes)
+            N->Fn();
+        return;
+    }
+
+    for (auto& N : m_Nodes)
+        N->Remaining = N->nDeps;
+    for (int i = 0; i < (int)m_Nodes.size(); ++i)
+    {
+        if (m_Nodes[i]->nDeps == 0)
+            Pool->Submit([this, Pool, i]() { Execute(*Pool, i); });
+    }
+
+    std::unique_lock<std::mutex> Guard(m_Lock);
+    while (m_Done < m_Nodes.size())
+    {
+        size_t Seen = m_Done;
+        Guard.unlock();
+        bool Ran = Pool->RunPending();
+        Guard.lock();
+        if (!Ran)
+            m_Progress.wait(Guard, [this, Seen]() { return m_Done != Seen; });
+    }
+    if (m_Error)
+        std::rethrow_exception(m_Error);
+}
+
+
+void parallel_for(ThreadPool* Pool, size_t Count, size_t MinChunk, const std::function<void(size_t, size_t)>& Fn,
+                  size_t Align)
+{
+    size_t nChunks = Pool == nullptr ? 1 : (size_t)Pool->GetThreads();
+    nChunks = std::max((size_t)1, std::min(nChunks, Count / std::max((size_t)1, MinChunk)));
+    if (nChunks == 1)
+    {
+        Fn(0, Count);
+        return;
+    }
+
+    Align = std::max((size_t)1, Align);
+    size_t Chunk = ((Count + nChunks - 1) / nChunks + Align - 1) / Align * Align;
+    TaskGraph Tasks;
+    for (size_t Begin = 0; Begin < Count; Begin += Chunk)
+    {
+        size_t End = std::min(Count, Begin + Chunk);
+        Tasks.Add([&Fn, Begin, End]() { Fn(Begin, End); });
+    }
+    Tasks.Run(Pool);
+}
\ No newline at end of file
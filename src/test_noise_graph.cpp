@@ -0,0 +1,266 @@
+/**
+ * @file        test_noise_graph.cpp
+ *
+ * @brief       Test noise graphs against the layers they replace, against graphs
+ *              evaluated by hand, and the tiling of their spectral nodes.
+ *
+ * @author      Filippo Maggioli\n
+ *              (maggioli@di.uniroma1.it, maggioli.filippo@gmail.com)\n
+ *              Sapienza, University of Rome - Department of Computer Science
+ *
+ * @date        2026-10-18
+ */
+#include <noise_graph.hpp>
+#include <noises.hpp>
+#include <profiler.hpp>
+#include <stb_perlin.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cmath>
+
+
+namespace
+{
+
+NoiseNode node(NoiseOp Op, int A = -1, int B = -1)
+{
+    NoiseNode N;
+    N.Op = Op;
+    N.A = A;
+    N.B = B;
+    return N;
+}
+
+NoiseNode constant(float Value)
+{
+    NoiseNode N = node(NoiseOp::Const);
+    N.Value = Value;
+    return N;
+}
+
+// The instructions the graph compiles to, from the counter of the profiler
+int64_t count_instructions(const NoiseGraph& G, int w, int h)
+{
+    Profiler::Reset();
+    Profiler::Enable(true);
+    HeightMap HM(w, h);
+    G.Evaluate(HM);
+    Profiler::Enable(false);
+
+    std::stringstream ss;
+    Profiler::PrintSummary(ss);
+    std::string Line;
+    while (std::getline(ss, Line))
+    {
+        std::stringstream Fields(Line);
+        std::string Name;
+        int64_t Value;
+        if (Fields >> Name >> Value && Name == "noise_graph.instructions")
+            return Value;
+    }
+    return -1;
+}
+
+// Fractal noise as the FBM nodes define it, written out for the reference maps
+float reference_fbm(float u, float v, int Octaves, int Seed)
+{
+    float f = 1.0f;
+    float a = 1.0f;
+    float Sum = 0.0f;
+    for (int o = 0; o < Octaves; ++o)
+    {
+        Sum += stb_perlin_noise3_seed(u * f, v * f, 0.0f, 0, 0, 0, Seed + o) * a;
+        f *= 2.0f;
+        a *= 0.5f;
+    }
+    return Sum;
+}
+
+// Maps must match up to Tol, which allows for the rounding of the references
+int compare(const char* What, const HeightMap& Got, const HeightMap& Expected, float Tol)
+{
+    float MaxErr = 0.0f;
+    for (int j = 0; j < Got.GetHeight(); ++j)
+    {
+        for (int i = 0; i < Got.GetWidth(); ++i)
+            MaxErr = std::max(MaxErr, std::abs(Got(i, j) - Expected(i, j)));
+    }
+    if (MaxErr > Tol)
+    {
+        std::cerr << What << " differs from its reference by " << MaxErr << '.' << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int check_instructions(const char* What, const NoiseGraph& G, int64_t Expected)
+{
+    int64_t n = count_instructions(G, 64, 32);
+    if (n != Expected)
+    {
+        std::cerr << What << " compiles to " << n << " instructions instead of " << Expected << '.' << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+
+// With seed 0 and the default lacunarity and gain, FBM and Cellular nodes add the
+// same values as add_perlin() and add_voronoi()
+int check_layers(int w, int h)
+{
+    int Failures = 0;
+    NoiseGraph Fbm;
+    NoiseNode F = node(NoiseOp::FBM);
+    F.Scale = 5.0f;
+    F.Octaves = 6;
+    Fbm.SetOutput(Fbm.Add(F));
+    HeightMap Got(w, h);
+    HeightMap Expected(w, h);
+    Fbm.Evaluate(Got, 0.8f);
+    add_perlin(Expected, 0.8f, 5.0f, 6);
+    Failures += compare("An FBM node", Got, Expected, 1e-6f);
+
+    NoiseGraph Cell;
+    NoiseNode C = node(NoiseOp::Cellular);
+    C.Scale = 6.0f;
+    Cell.SetOutput(Cell.Add(C));
+    HeightMap GotC(w, h);
+    HeightMap ExpectedC(w, h);
+    Cell.Evaluate(GotC, 0.4f);
+    add_voronoi(ExpectedC, 0.4f, 6.0f);
+    Failures += compare("A Cellular node", GotC, ExpectedC, 1e-6f);
+    return Failures;
+}
+
+// clamp((2 + 3) * cellular + fbm, -0.5, 2.5) * 1: the constants fold, the product
+// fuses with the sum, and the product by one is dropped, leaving the two generators,
+// the fused product and the clamp
+int check_arithmetic(int w, int h)
+{
+    NoiseGraph G;
+    int Five = G.Add(node(NoiseOp::Add, G.Add(constant(2.0f)), G.Add(constant(3.0f))));
+    NoiseNode C = node(NoiseOp::Cellular);
+    C.Scale = 4.0f;
+    C.Seed = 7;
+    int Weighted = G.Add(node(NoiseOp::Mul, G.Add(C), Five));
+    NoiseNode F = node(NoiseOp::FBM);
+    F.Scale = 3.0f;
+    F.Octaves = 2;
+    int Sum = G.Add(node(NoiseOp::Add, Weighted, G.Add(F)));
+    NoiseNode Clamp = node(NoiseOp::Clamp, Sum);
+    Clamp.Min = -0.5f;
+    Clamp.Max = 2.5f;
+    G.SetOutput(G.Add(node(NoiseOp::Mul, G.Add(constant(1.0f)), G.Add(Clamp))));
+
+    HeightMap Got(w, h);
+    HeightMap Expected(w, h);
+    G.Evaluate(Got);
+    for (int j = 0; j < h; ++j)
+    {
+        float v = j / (float)(h - 1);
+        for (int i = 0; i < w; ++i)
+        {
+            float u = i / (float)(w - 1);
+            float x = 5.0f * voronoi_distance(u * 4.0f, v * 4.0f, 7) + reference_fbm(u * 3.0f, v * 3.0f, 2, 0);
+            Expected.Set(i, j, std::min(std::max(x, -0.5f), 2.5f));
+        }
+    }
+    int Failures = compare("An arithmetic graph", Got, Expected, 1e-5f);
+    Failures += check_instructions("An arithmetic graph", G, 4);
+    return Failures;
+}
+
+// warp(fbm) + fbm: the shared FBM node is evaluated at both the warped and the
+// map coordinates, which live in distinct registers
+int check_warp(int w, int h)
+{
+    NoiseGraph G;
+    NoiseNode F = node(NoiseOp::FBM);
+    F.Scale = 2.0f;
+    F.Octaves = 3;
+    F.Seed = 1;
+    int Field = G.Add(F);
+    NoiseNode W = node(NoiseOp::Warp, Field);
+    W.Scale = 1.5f;
+    W.Octaves = 2;
+    W.Seed = 5;
+    W.Amount = 0.3f;
+    G.SetOutput(G.Add(node(NoiseOp::Add, G.Add(W), Field)));
+
+    HeightMap Got(w, h);
+    HeightMap Expected(w, h);
+    G.Evaluate(Got);
+    for (int j = 0; j < h; ++j)
+    {
+        float v = j / (float)(h - 1);
+        for (int i = 0; i < w; ++i)
+        {
+            float u = i / (float)(w - 1);
+            float wu = u + 0.3f * reference_fbm(u * 1.5f, v * 1.5f, 2, 5);
+            float wv = v + 0.3f * reference_fbm(u * 1.5f, v * 1.5f, 2, 5 + 101);
+            Expected.Set(i, j, reference_fbm(wu * 2.0f, wv * 2.0f, 3, 1) + reference_fbm(u * 2.0f, v * 2.0f, 3, 1));
+        }
+    }
+    int Failures = compare("A warp graph", Got, Expected, 1e-5f);
+    Failures += check_instructions("A warp graph", G, 4);
+    return Failures;
+}
+
+// With scale periods across the map, columns and rows (w - 1) / scale apart
+// have the same coordinates modulo a period, so they must match
+int check_tiling(int w, int h, int Scale)
+{
+    NoiseGraph G;
+    NoiseNode N;
+    N.Op = NoiseOp::Spectral;
+    N.Scale = (float)Scale;
+    N.Beta = 2.0f;
+    N.Seed = 3;
+    G.SetOutput(G.Add(N));
+    HeightMap HM(w, h);
+    G.Evaluate(HM);
+
+    const float Tol = 1e-3f;
+    int px = (w - 1) / Scale;
+    int py = (h - 1) / Scale;
+    float MaxErr = 0.0f;
+    for (int j = 0; j < h; ++j)
+    {
+        for (int i = 0; i + px < w; ++i)
+            MaxErr = std::max(MaxErr, std::abs(HM(i + px, j) - HM(i, j)));
+    }
+    for (int j = 0; j + py < h; ++j)
+    {
+        for (int i = 0; i < w; ++i)
+            MaxErr = std::max(MaxErr, std::abs(HM(i, j + py) - HM(i, j)));
+    }
+    if (MaxErr > Tol)
+    {
+        std::cerr << "A spectral node of scale " << Scale << " on a " << w << "-by-" << h
+                  << " map does not tile: points a period apart differ by " << MaxErr << '.' << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+
+int main(int argc, const char * const argv[])
+{
+    int Failures = 0;
+    Failures += check_layers(300, 200);
+    Failures += check_arithmetic(300, 200);
+    Failures += check_warp(300, 200);
+    Failures += check_tiling(257, 129, 1);
+    Failures += check_tiling(257, 129, 2);
+    Failures += check_tiling(301, 151, 3);
+    Failures += check_tiling(513, 257, 4);
+
+    if (Failures > 0)
+        return 1;
+    std::cout << "Noise graphs match their references, and spectral nodes tile." << std::endl;
+    return 0;
+}
\ No newline at end of file